@@ -7,16 +7,20 @@
  */
 
 #include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <crypto/api.h>
 #include <crypto/core.h>
+#include <crypto/cpu.h>
 #include <crypto/utils.h>
 
 #include <hash/md5.h>
 #include <hash/sha1.h>
 #include <hash/stribog.h>
+#include <hash/stribog-tree.h>
 
 #include <cipher/kuznechik.h>
 #include <cipher/magma.h>
@@ -32,79 +36,458 @@
 #include <kdf/pbkdf1.h>
 #include <kdf/pbkdf2.h>
 
+/*
+ * Algorithm could have several implementations (backends): the one with
+ * highest priority supported by current CPU is used unless other backend
+ * is forced with crypto_set_backend.
+ */
 struct core_map {
 	const char *algo;
 	const struct crypto_core *core;
+	const char *backend;
+	unsigned features;	/* required CPU features */
+	int priority;
 };
 
+/* keep sorted by name, lookup is a binary search */
 static const struct core_map map[] = {
-	{"md5",		&md5_core	},
-	{"sha1",	&sha1_core	},
-	{"stribog",	&stribog_core	},
-	{"stribog-256",	&stribog_256_core	},
-
-	{"kuznechik",	&kuznechik_core	},
-	{"magma",	&magma_core	},
-	{"gost89",	&gost89_core	},
-
-	{"hmac",	&hmac_core	},
-	{"cmac",	&cmac_core	},
-
-	{"cbc",		&cbc_core	},
-	{"cfb",		&cfb_core	},
-	{"ctr",		&ctr_core	},
-	{"ofb",		&ofb_core	},
-
-	{"pbkdf1",	&pbkdf1_core	},
-	{"pbkdf2",	&pbkdf2_core	},
-	{},
+	{"cbc",		&cbc_core,		"generic",	0,  0	},
+	{"cfb",		&cfb_core,		"generic",	0,  0	},
+	{"cmac",	&cmac_core,		"generic",	0,  0	},
+	{"ctr",		&ctr_core,		"generic",	0,  0	},
+	{"gost89",	&gost89_core,		"table",	0, 10	},
+	{"gost89",	&gost89_wide_core,	"table16",	0,  5	},
+	{"gost89",	&gost89_bs_core,	"bitslice",	0, 15	},
+#ifdef CRYPTO_CPU_X86
+	{"gost89",	&gost89_avx2_core,	"avx2",		CRYPTO_CPU_AVX2,  20	},
+#endif
+	{"hmac",	&hmac_core,		"generic",	0,  0	},
+	{"kuznechik",	&kuznechik_core,	"table",	0, 10	},
+	{"kuznechik",	&kuznechik_ref_core,	"ref",		0,  0	},
+	{"kuznechik",	&kuznechik_compact_core, "compact",	0,  2	},
+#ifdef CRYPTO_CPU_X86
+	{"kuznechik",	&kuznechik_ssse3_core,	"ssse3",	CRYPTO_CPU_SSSE3,  5	},
+	{"kuznechik",	&kuznechik_avx2_core,	"avx2",		CRYPTO_CPU_AVX2,   8	},
+	{"kuznechik",	&kuznechik_avx512_core,	"avx512",
+			CRYPTO_CPU_AVX512 | CRYPTO_CPU_GFNI,		  20	},
+#endif
+	{"kuznechik-enc", &kuznechik_enc_core,	"table",	0, 10	},
+	{"kuznechik-enc", &kuznechik_enc_compact_core, "compact", 0, 2	},
+#ifdef CRYPTO_CPU_X86
+	{"kuznechik-enc", &kuznechik_enc_avx512_core, "avx512",
+			CRYPTO_CPU_AVX512 | CRYPTO_CPU_GFNI,		  20	},
+#endif
+	{"magma",	&magma_core,		"table",	0, 10	},
+	{"magma",	&magma_wide_core,	"table16",	0,  5	},
+	{"magma",	&magma_bs_core,		"bitslice",	0, 15	},
+#ifdef CRYPTO_CPU_X86
+	{"magma",	&magma_avx2_core,	"avx2",		CRYPTO_CPU_AVX2,  20	},
+#endif
+	{"md5",		&md5_core,		"generic",	0,  0	},
+	{"ofb",		&ofb_core,		"generic",	0,  0	},
+	{"pbkdf1",	&pbkdf1_core,		"generic",	0,  0	},
+	{"pbkdf2",	&pbkdf2_core,		"generic",	0,  0	},
+	{"sha1",	&sha1_core,		"generic",	0,  0	},
+	{"stribog",	&stribog_core,		"generic",	0,  0	},
+#ifdef CRYPTO_CPU_X86
+	{"stribog",	&stribog_sse2_core,	"sse2",		CRYPTO_CPU_SSE2,   5	},
+#endif
+	{"stribog-256",	&stribog_256_core,	"generic",	0,  0	},
+#ifdef CRYPTO_CPU_X86
+	{"stribog-256",	&stribog_256_sse2_core,	"sse2",		CRYPTO_CPU_SSE2,   5	},
+#endif
+	{"stribog-tree", &stribog_tree_core,	"generic",	0,  0	},
+};
+
+#define MAP_SIZE  (sizeof (map) / sizeof (map[0]))
+
+/* backends forced by user, accessed atomically: set from any thread */
+static char forced[MAP_SIZE];
+
+struct core_name {
+	const char *algo;
+	size_t len;
 };
 
-static const struct crypto_core *find (const char *algo)
+static int core_cmp (const void *key, const void *entry)
 {
+	const struct core_name *k = key;
+	const struct core_map *e = entry;
+	int ret;
+
+	if ((ret = strncmp (k->algo, e->algo, k->len)) != 0)
+		return ret;
+
+	return e->algo[k->len] == '\0' ? 0 : -1;
+}
+
+/* returns first entry of algorithm implementations */
+static const struct core_map *find_entry (const char *algo, size_t len)
+{
+	const struct core_name key = { algo, len };
 	const struct core_map *p;
 
-	for (p = map; p->algo != NULL; ++p)
-		if (strcmp (p->algo, algo) == 0)
+	p = bsearch (&key, map, MAP_SIZE, sizeof (map[0]), core_cmp);
+	if (p == NULL) {
+		errno = ENOENT;
+		return NULL;
+	}
+
+	for (; p > map && core_cmp (&key, p - 1) == 0; --p) {}
+
+	return p;
+}
+
+static int same_algo (const struct core_map *a, const struct core_map *b)
+{
+	return b < map + MAP_SIZE && strcmp (a->algo, b->algo) == 0;
+}
+
+static void load_backends (void);
+
+static const struct crypto_core *find (const char *algo, size_t len)
+{
+	const struct core_map *first, *p, *best = NULL;
+	const unsigned features = crypto_cpu_features ();
+
+	load_backends ();
+
+	if ((first = find_entry (algo, len)) == NULL)
+		return NULL;
+
+	for (p = first; same_algo (first, p); ++p) {
+		if ((p->features & ~features) != 0)
+			continue;
+
+		if (__atomic_load_n (&forced[p - map], __ATOMIC_RELAXED))
 			return p->core;
 
-	errno = ENOENT;
-	return NULL;
+		if (best == NULL || p->priority > best->priority)
+			best = p;
+	}
+
+	if (best == NULL) {
+		errno = ENOTSUP;
+		return NULL;
+	}
+
+	return best->core;
 }
 
-struct crypto *crypto_alloc (const char *algo)
+static int set_backend (const char *algo, const char *backend)
 {
-	const struct crypto_core *core;
-	struct crypto *o;
+	const struct core_map *first, *p, *q = NULL;
+
+	if ((first = find_entry (algo, strlen (algo))) == NULL)
+		return 0;
+
+	for (p = first; backend != NULL && same_algo (first, p); ++p)
+		if (strcmp (p->backend, backend) == 0)
+			q = p;
+
+	if (backend != NULL && q == NULL) {
+		errno = ENOENT;
+		return 0;
+	}
+
+	if (q != NULL && (q->features & ~crypto_cpu_features ()) != 0) {
+		errno = ENOTSUP;
+		return 0;
+	}
 
+	for (p = first; same_algo (first, p); ++p)
+		__atomic_store_n (&forced[p - map], p == q, __ATOMIC_RELAXED);
+
+	return 1;
+}
+
+int crypto_set_backend (const char *algo, const char *backend)
+{
 	if (algo == NULL) {
 		errno = EINVAL;
-		return NULL;
+		return 0;
 	}
 
-	if ((core = find (algo)) == NULL || (o = core->alloc ()) == NULL)
-		return NULL;
+	load_backends ();
+	return set_backend (algo, backend);
+}
+
+/* CRYPTO_BACKEND = algo:backend[,algo:backend...] */
+static void parse_backends (void)
+{
+	const char *env;
+	char *list, *p, *backend, *last;
+
+	if ((env = getenv ("CRYPTO_BACKEND")) == NULL ||
+	    (list = strdup (env)) == NULL)
+		return;
+
+	for (p = strtok_r (list, ",", &last); p != NULL;
+	     p = strtok_r (NULL, ",", &last))
+		if ((backend = strchr (p, ':')) != NULL) {
+			*backend++ = '\0';
+			set_backend (p, backend);
+		}
+
+	free (list);
+}
+
+static void load_backends (void)
+{
+	static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+	pthread_once (&once, parse_backends);
+}
+
+static size_t state_size (const struct crypto_core *core)
+{
+	const size_t a = CRYPTO_STATE_ALIGN;
+
+	return (core->size + a - 1) / a * a;
+}
 
+static void crypto_setup (struct crypto *o, const struct crypto_core *core,
+			  int flags)
+{
 	o->core  = core;
 	o->block = NULL;
 	o->avail = 0;
+	o->block_size  = core->block_size;
+	o->output_size = core->output_size;
+	o->flags = flags;
+}
+
+static int crypto_set (struct crypto *o, int type, ...);
+static void crypto_cache_sizes (struct crypto *o);
+
+/*
+ * Algorithm specification: name of algorithm optionally followed by the
+ * specification of inner algorithm in parentheses, for example
+ * "pbkdf2(hmac(stribog))". Chain of cores is stored outer first.
+ */
+#define CRYPTO_SPEC_DEPTH  4
+
+struct crypto_spec {
+	size_t count;
+	size_t size;  /* total size of chain states */
+	const struct crypto_core *core[CRYPTO_SPEC_DEPTH];
+};
+
+static int spec_parse (struct crypto_spec *o, const char *spec)
+{
+	const char *p;
+	size_t len, i;
+
+	if (spec == NULL)
+		return -EINVAL;
+
+	for (p = spec, o->count = 0, o->size = 0; ; ++p) {
+		if ((len = strcspn (p, "()")) == 0 ||
+		    o->count == CRYPTO_SPEC_DEPTH)
+			return -EINVAL;
+
+		if ((o->core[o->count] = find (p, len)) == NULL)
+			return -ENOENT;
+
+		o->size += state_size (o->core[o->count++]);
+
+		if (*(p += len) != '(')
+			break;
+	}
+
+	for (i = 1; i < o->count; ++i, ++p)
+		if (*p != ')')
+			return -EINVAL;
+
+	return *p == '\0' ? 0 : -EINVAL;
+}
+
+/* construct chain in buf, innermost object placed last */
+static struct crypto *
+spec_build (const struct crypto_spec *o, void *buf, int flags)
+{
+	struct crypto *c, *inner = NULL;
+	size_t i, offset = o->size;
+	int ret;
+
+	for (i = o->count; i > 0; --i, inner = c) {
+		offset -= state_size (o->core[i - 1]);
+		c = (void *) ((char *) buf + offset);
+
+		crypto_setup (c, o->core[i - 1], 0);
+		c->core->init (c);
+
+		if (inner == NULL)
+			continue;
+
+		if ((ret = crypto_set (c, CRYPTO_ALGO, inner)) != 0) {
+			if (ret == -ENOSYS)
+				crypto_free (inner);
+
+			crypto_free (c);
+			errno = -ret;
+			return NULL;
+		}
+
+		crypto_cache_sizes (c);
+	}
+
+	inner->flags = flags;
+	return inner;
+}
+
+struct crypto_spec *crypto_spec_parse (const char *spec)
+{
+	struct crypto_spec *o;
+	int ret;
+
+	if ((o = malloc (sizeof (*o))) == NULL)
+		return NULL;
+
+	if ((ret = spec_parse (o, spec)) != 0) {
+		free (o);
+		errno = -ret;
+		return NULL;
+	}
+
 	return o;
 }
 
+void crypto_spec_free (struct crypto_spec *o)
+{
+	free (o);
+}
+
+size_t crypto_spec_size (const struct crypto_spec *o)
+{
+	return o->size;
+}
+
+struct crypto *crypto_spec_alloc (const struct crypto_spec *o)
+{
+	struct crypto *c;
+	void *buf;
+
+	if ((buf = malloc (o->size)) == NULL)
+		return NULL;
+
+	if ((c = spec_build (o, buf, CRYPTO_HEAP)) == NULL)
+		free (buf);
+
+	return c;
+}
+
+struct crypto *crypto_spec_init (void *buf, const struct crypto_spec *o)
+{
+	if (buf == NULL || (uintptr_t) buf % CRYPTO_STATE_ALIGN != 0) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	return spec_build (o, buf, 0);
+}
+
+struct crypto *crypto_alloc (const char *algo)
+{
+	struct crypto_spec spec;
+	int ret;
+
+	if ((ret = spec_parse (&spec, algo)) != 0) {
+		errno = -ret;
+		return NULL;
+	}
+
+	return crypto_spec_alloc (&spec);
+}
+
+size_t crypto_state_size (const char *algo)
+{
+	struct crypto_spec spec;
+	int ret;
+
+	if ((ret = spec_parse (&spec, algo)) != 0) {
+		errno = -ret;
+		return 0;
+	}
+
+	return spec.size;
+}
+
+struct crypto *crypto_init (void *buf, const char *algo)
+{
+	struct crypto_spec spec;
+	int ret;
+
+	if ((ret = spec_parse (&spec, algo)) != 0) {
+		errno = -ret;
+		return NULL;
+	}
+
+	return crypto_spec_init (buf, &spec);
+}
+
 void crypto_free (struct crypto *o)
 {
 	if (o == NULL)
 		return;
 
 	if (o->block != NULL)
-		memset_secure (o->block, 0, o->avail);
+		memset_secure (o->block, 0, crypto_get_block_size (o));
 
-	free (o->block);
-	o->core->free (o);
+	o->core->fini (o);
+
+	if ((o->flags & CRYPTO_HEAP) != 0)
+		free (o);
+}
+
+struct crypto *crypto_clone (const struct crypto *o)
+{
+	const struct crypto_core *core = o->core;
+	struct crypto *c;
+	int ret;
+
+	if (core->clone == NULL) {
+		errno = ENOSYS;
+		return NULL;
+	}
+
+	if ((c = malloc (state_size (core))) == NULL)
+		return NULL;
+
+	if ((ret = core->clone (c, o)) != 0) {
+		memset_secure (c, 0, core->size);
+		free (c);
+		errno = -ret;
+		return NULL;
+	}
+
+	c->flags = CRYPTO_HEAP;
+
+	/* rebase pointer to inline block buffer */
+	if (o->block != NULL)
+		c->block = (char *) c + ((char *) o->block - (char *) o);
+
+	return c;
 }
 
 int crypto_getv (const struct crypto *o, int type, va_list ap)
 {
+	switch (type) {
+	case CRYPTO_BLOCK_SIZE:
+		if (o->block_size != 0)
+			return o->block_size;
+
+		break;
+	case CRYPTO_OUTPUT_SIZE:
+		if (o->output_size != 0)
+			return o->output_size;
+
+		break;
+	}
+
+	if (o->core->get == NULL)
+		return -ENOSYS;
+
 	return o->core->get (o, type, ap);
 }
 
@@ -119,7 +502,7 @@ static int crypto_get (const struct crypto *o, int type, ...)
 	int ret;
 
 	va_start (ap, type);
-	ret = o->core->get (o, type, ap);
+	ret = crypto_getv (o, type, ap);
 	va_end (ap);
 	return ret;
 }
@@ -137,6 +520,10 @@ static int crypto_set (struct crypto *o, int type, ...)
 
 void crypto_reset (struct crypto *o)
 {
+	if (o->block != NULL)
+		memset_secure (o->block, 0, crypto_get_block_size (o));
+
+	o->avail = 0;
 	errno = -crypto_set (o, CRYPTO_RESET);
 }
 
@@ -144,6 +531,9 @@ void crypto_reset (struct crypto *o)
 
 size_t crypto_get_block_size (struct crypto *o)
 {
+	if (o->block_size != 0)
+		return o->block_size;
+
 	int ret = crypto_get (o, CRYPTO_BLOCK_SIZE);
 
 	if (ret == 0)
@@ -159,6 +549,9 @@ size_t crypto_get_block_size (struct crypto *o)
 
 size_t crypto_get_output_size (struct crypto *o)
 {
+	if (o->output_size != 0)
+		return o->output_size;
+
 	int ret = crypto_get (o, CRYPTO_OUTPUT_SIZE);
 
 	if (ret == 0)
@@ -172,6 +565,23 @@ size_t crypto_get_output_size (struct crypto *o)
 	return ret;
 }
 
+/* sizes of composite algorithms are known once inner algorithm is set */
+
+static void crypto_cache_sizes (struct crypto *o)
+{
+	int ret;
+
+	o->block_size  = o->core->block_size;
+	o->output_size = o->core->output_size;
+
+	if (o->block_size == 0 && (ret = crypto_get (o, CRYPTO_BLOCK_SIZE)) > 0)
+		o->block_size = ret;
+
+	if (o->output_size == 0 &&
+	    (ret = crypto_get (o, CRYPTO_OUTPUT_SIZE)) > 0)
+		o->output_size = ret;
+}
+
 /* returns non-zero on success, zero overwise */
 
 int crypto_set_algo (struct crypto *o, struct crypto *algo)
@@ -181,6 +591,7 @@ int crypto_set_algo (struct crypto *o, struct crypto *algo)
 	if (errno == ENOSYS)
 		crypto_free (algo);
 
+	crypto_cache_sizes (o);
 	return errno == 0;
 }
 
@@ -214,6 +625,12 @@ int crypto_set_count (struct crypto *o, size_t count)
 	return errno == 0;
 }
 
+int crypto_set_threads (struct crypto *o, size_t count)
+{
+	errno = -crypto_set (o, CRYPTO_THREADS, count);
+	return errno == 0;
+}
+
 /* process one block of data */
 
 int crypto_encrypt (struct crypto *o, const void *in, void *out)
@@ -238,61 +655,191 @@ int crypto_decrypt (struct crypto *o, const void *in, void *out)
 	return 0;
 }
 
+/* process count blocks of data */
+
+typedef void crypt_fn (void *state, const void *in, void *out);
+typedef void crypt_n_fn (void *state, const void *in, void *out, size_t count);
+
+static int
+crypto_crypt_blocks (struct crypto *o, crypt_fn *fn, crypt_n_fn *fn_n,
+		     const void *src, void *dst, size_t count)
+{
+	const u8 *in = src;
+	u8 *out = dst;
+	size_t bs;
+
+	if (fn_n != NULL) {
+		fn_n (o, in, out, count);
+		return 1;
+	}
+
+	if (fn == NULL) {
+		errno = ENOSYS;
+		return 0;
+	}
+
+	if ((bs = crypto_get_block_size (o)) == 0)
+		return 0;
+
+	for (; count > 0; --count, in += bs, out += bs)
+		fn (o, in, out);
+
+	return 1;
+}
+
+int crypto_encrypt_blocks (struct crypto *o, const void *in, void *out,
+			   size_t count)
+{
+	return crypto_crypt_blocks (o, o->core->encrypt, o->core->encrypt_n,
+				    in, out, count);
+}
+
+int crypto_decrypt_blocks (struct crypto *o, const void *in, void *out,
+			   size_t count)
+{
+	return crypto_crypt_blocks (o, o->core->decrypt, o->core->decrypt_n,
+				    in, out, count);
+}
+
 /* update/fetch helpers */
 
 #include <crypto/types.h>
 
-static int crypto_hash_update (struct crypto *o, const void *in, size_t len)
+/*
+ * Hash and MAC cores keep partial block buffer inline, it is wiped only on
+ * final and reset, not after every flushed block. Whole blocks are fed to
+ * transform directly, even if they span fragments, only the last (possibly
+ * full) block is copied into the buffer to be processed by final.
+ */
+static int crypto_hash_updatev (struct crypto *o, const struct iovec *iov,
+				size_t count)
 {
 	const size_t bs = crypto_get_block_size (o);
-	const char *data = in;
-	size_t tail;
+	const char *data;
+	size_t i, len, rest, n;
 
-	if (bs == 0 || o->avail > bs)
+	if (bs == 0 || o->block == NULL || o->avail > bs)
 		return -EINVAL;
 
-	if (o->block == NULL && (o->block = malloc (bs)) == NULL)
-		return -ENOMEM;
+	for (i = 0, rest = 0; i < count; ++i)
+		rest += iov[i].iov_len;
+
+	for (; count > 0; ++iov, --count)
+		for (data = iov->iov_base, len = iov->iov_len; len > 0;) {
+			if (o->avail == bs) {
+				o->core->transform (o, o->block);
+				o->avail = 0;
+			}
+
+			if (o->avail == 0 && len >= bs && rest > bs) {
+				o->core->transform (o, data);
+				data += bs, len -= bs, rest -= bs;
+				continue;
+			}
 
-	if (o->avail == bs && len == 0)
-		goto out;  /* it is a last block, delay processing */
+			n = bs - o->avail < len ? bs - o->avail : len;
 
-	if (o->avail > 0) {
-		tail = bs - o->avail;
+			memcpy (o->block + o->avail, data, n);
+			o->avail += n;
+			data += n, len -= n, rest -= n;
+		}
 
-		if (len < tail)
-			goto out;
+	return 0;
+}
+
+/*
+ * Cipher cores and modes transform fragments in place. Whole blocks are
+ * encrypted straight in fragment memory, a block that spans fragments is
+ * gathered on stack, encrypted and scattered back.
+ */
+static void scatter (const struct iovec *iov, size_t off, const u8 *in,
+		     size_t len)
+{
+	size_t n;
 
-		memcpy (o->block + o->avail, data, tail);
-		data += tail, len -= tail;
-		o->core->transform (o, o->block);
-		memset_secure (o->block, 0, bs);
-		o->avail = 0;
+	for (; len > 0; ++iov, off = 0) {
+		n = iov->iov_len - off < len ? iov->iov_len - off : len;
+
+		memcpy ((u8 *) iov->iov_base + off, in, n);
+		in += n, len -= n;
 	}
+}
 
-	for (; len > bs; data += bs, len -= bs)
-		o->core->transform (o, data);
+static int crypto_crypt_updatev (struct crypto *o, const struct iovec *iov,
+				 size_t count)
+{
+	const size_t bs = crypto_get_block_size (o);
+	size_t i, len, avail, n, off = 0;
+	const struct iovec *head = iov;
+	u8 *data;
+
+	if (bs == 0)
+		return -EINVAL;
+
+	for (i = 0, len = 0; i < count; ++i)
+		len += iov[i].iov_len;
+
+	if (len % bs != 0)
+		return -EINVAL;
+
+	u8 block[bs];
+
+	for (avail = 0; count > 0; ++iov, --count) {
+		data = iov->iov_base, len = iov->iov_len;
+
+		if (avail > 0) {
+			n = bs - avail < len ? bs - avail : len;
+
+			memcpy (block + avail, data, n);
+			avail += n, data += n, len -= n;
+
+			if (avail < bs)
+				continue;
+
+			o->core->encrypt (o, block, block);
+			scatter (head, off, block, bs);
+			avail = 0;
+		}
 
-out:
-	memcpy (o->block + o->avail, data, len);
-	o->avail += len;
+		if ((n = len / bs) > 0 &&
+		    !crypto_encrypt_blocks (o, data, data, n))
+			return -errno;
+
+		data += n * bs, len -= n * bs;
+
+		if (len > 0) {
+			head = iov, off = data - (u8 *) iov->iov_base;
+			memcpy (block, data, len);
+			avail = len;
+		}
+	}
+
+	memset_secure (block, 0, bs);
 	return 0;
 }
 
+static int crypto_hash_update (struct crypto *o, const void *in, size_t len)
+{
+	const struct iovec iov = { (void *) in, len };
+
+	return crypto_hash_updatev (o, &iov, 1);
+}
+
 static int crypto_hash_fetch (struct crypto *o, void *out, size_t len)
 {
 	const size_t hs = crypto_get_output_size (o);
 
-	if (hs == 0 || len > hs)
+	if (hs == 0 || len > hs || o->block == NULL)
 		return -EINVAL;
 
 	u8 hash[hs];
 
 	o->core->final (o, o->block, o->avail, hash);
-	memset_secure (o->block, 0, o->avail);
+	memset_secure (o->block, 0, crypto_get_block_size (o));
 	o->avail = 0;
 
 	memcpy (out, hash, len);
+	memset_secure (hash, 0, hs);
 	return 0;
 }
 
@@ -314,6 +861,33 @@ int crypto_update (struct crypto *o, const void *in, size_t len)
 	return 0;
 }
 
+int crypto_updatev (struct crypto *o, const struct iovec *iov, size_t count)
+{
+	size_t i;
+
+	if (o->core->update != NULL) {
+		for (i = 0; i < count; ++i)
+			if ((errno = -o->core->update (o, iov[i].iov_base,
+							  iov[i].iov_len)) != 0)
+				return 0;
+
+		return 1;
+	}
+
+	if (o->core->transform != NULL) {
+		errno = -crypto_hash_updatev (o, iov, count);
+		return errno == 0;
+	}
+
+	if (o->core->encrypt != NULL) {
+		errno = -crypto_crypt_updatev (o, iov, count);
+		return errno == 0;
+	}
+
+	errno = ENOSYS;
+	return 0;
+}
+
 int crypto_fetch (struct crypto *o, void *out, size_t len)
 {
 	if (o->core->fetch != NULL) {
@@ -329,3 +903,199 @@ int crypto_fetch (struct crypto *o, void *out, size_t len)
 	errno = -ENOSYS;
 	return 0;
 }
+
+/*
+ * One-shot processing: the core is resolved once, all the state is kept on
+ * stack and generic update buffering is skipped. Composite algorithms are
+ * described by outer (mac or mode) and inner (hash or cipher) names.
+ */
+
+static const struct crypto_core *find_once (const char *algo)
+{
+	if (algo == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	return find (algo, strlen (algo));
+}
+
+static int crypto_once_chain (struct crypto *o, struct crypto *inner,
+			      const void *key, size_t len)
+{
+	int ret;
+
+	if ((ret = crypto_set (o, CRYPTO_ALGO, inner)) != 0) {
+		if (ret == -ENOSYS)
+			crypto_free (inner);
+
+		return ret;
+	}
+
+	crypto_cache_sizes (o);
+	return crypto_set (o, CRYPTO_KEY, key, len);
+}
+
+static size_t crypto_hash_once (struct crypto *o, const void *in, size_t len,
+				void *out)
+{
+	const size_t bs = crypto_get_block_size  (o);
+	const size_t hs = crypto_get_output_size (o);
+	const char *data = in;
+
+	if (bs == 0 || hs == 0)
+		return 0;
+
+	if (o->core->transform == NULL || o->core->final == NULL) {
+		errno = ENOSYS;
+		return 0;
+	}
+
+	/* last block, even a full one, is left to final */
+	for (; len > bs; data += bs, len -= bs)
+		o->core->transform (o, data);
+
+	o->core->final (o, data, len, out);
+	return hs;
+}
+
+size_t crypto_digest (const char *algo, const void *in, size_t len, void *out)
+{
+	const struct crypto_core *core;
+	size_t ret;
+
+	if ((core = find_once (algo)) == NULL)
+		return 0;
+
+	_Alignas (CRYPTO_STATE_ALIGN) char buf[state_size (core)];
+	struct crypto *o = (void *) buf;
+
+	crypto_setup (o, core, 0);
+	core->init (o);
+
+	ret = crypto_hash_once (o, in, len, out);
+	crypto_free (o);
+	return ret;
+}
+
+size_t crypto_digest_many (const char *algo, const struct iovec *in,
+			   size_t count, void *out)
+{
+	const struct crypto_core *core;
+	char *p = out;
+	size_t hs, i;
+
+	if ((core = find_once (algo)) == NULL)
+		return 0;
+
+	_Alignas (CRYPTO_STATE_ALIGN) char buf[state_size (core)];
+	struct crypto *o = (void *) buf;
+
+	crypto_setup (o, core, 0);
+	core->init (o);
+
+	hs = crypto_get_output_size (o);
+
+	if (hs != 0 && core->digest_n != NULL)
+		core->digest_n (o, in, count, out);
+	else
+		for (i = 0; hs != 0 && i < count; ++i, p += hs)
+			if (crypto_hash_once (o, in[i].iov_base, in[i].iov_len,
+					      p) != hs)
+				hs = 0;
+
+	crypto_free (o);
+	return hs;
+}
+
+size_t crypto_mac (const char *mac, const char *algo,
+		   const void *key, size_t klen,
+		   const void *in, size_t len, void *out)
+{
+	const struct crypto_core *outer, *inner;
+	size_t ret = 0;
+	int status;
+
+	if ((outer = find_once (mac)) == NULL ||
+	    (inner = find_once (algo)) == NULL)
+		return 0;
+
+	_Alignas (CRYPTO_STATE_ALIGN) char obuf[state_size (outer)];
+	_Alignas (CRYPTO_STATE_ALIGN) char ibuf[state_size (inner)];
+	struct crypto *o = (void *) obuf, *i = (void *) ibuf;
+
+	crypto_setup (o, outer, 0);
+	outer->init (o);
+	crypto_setup (i, inner, 0);
+	inner->init (i);
+
+	if ((status = crypto_once_chain (o, i, key, klen)) != 0)
+		errno = -status;
+	else
+		ret = crypto_hash_once (o, in, len, out);
+
+	crypto_free (o);
+	return ret;
+}
+
+static int crypto_crypt_once (int encrypt, const char *mode, const char *algo,
+			      const void *key, size_t klen,
+			      const void *iv, size_t ivlen,
+			      const void *in, void *out, size_t count)
+{
+	const struct crypto_core *outer = NULL, *inner;
+	int ret, ok = 0;
+
+	if ((mode != NULL && (outer = find_once (mode)) == NULL) ||
+	    (inner = find_once (algo)) == NULL)
+		return 0;
+
+	_Alignas (CRYPTO_STATE_ALIGN)
+		char obuf[outer == NULL ? CRYPTO_STATE_ALIGN : state_size (outer)];
+	_Alignas (CRYPTO_STATE_ALIGN) char ibuf[state_size (inner)];
+	struct crypto *o = (void *) obuf, *i = (void *) ibuf;
+
+	crypto_setup (i, inner, 0);
+	inner->init (i);
+
+	if (outer == NULL) {
+		o = i;
+		ret = crypto_set (o, CRYPTO_KEY, key, klen);
+	}
+	else {
+		crypto_setup (o, outer, 0);
+		outer->init (o);
+		ret = crypto_once_chain (o, i, key, klen);
+	}
+
+	if (ret == 0 && iv != NULL)
+		ret = crypto_set (o, CRYPTO_IV, iv, ivlen);
+
+	if (ret != 0)
+		errno = -ret;
+	else if (encrypt)
+		ok = crypto_encrypt_blocks (o, in, out, count);
+	else
+		ok = crypto_decrypt_blocks (o, in, out, count);
+
+	crypto_free (o);
+	return ok;
+}
+
+int crypto_encrypt_once (const char *mode, const char *algo,
+			 const void *key, size_t klen,
+			 const void *iv, size_t ivlen,
+			 const void *in, void *out, size_t count)
+{
+	return crypto_crypt_once (1, mode, algo, key, klen, iv, ivlen,
+				  in, out, count);
+}
+
+int crypto_decrypt_once (const char *mode, const char *algo,
+			 const void *key, size_t klen,
+			 const void *iv, size_t ivlen,
+			 const void *in, void *out, size_t count)
+{
+	return crypto_crypt_once (0, mode, algo, key, klen, iv, ivlen,
+				  in, out, count);
+}
@@ -0,0 +1,45 @@
+/*
+ * Kuznechik Cipher Algorithm: AVX2 Engine
+ *
+ * Copyright (c) 2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * Standard: GOST R 34.12-2015
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifdef __AVX2__
+
+#include <immintrin.h>
+
+#include "kuznechik-simd.h"
+
+/* two groups of 16 blocks, one per 128-bit lane */
+typedef __m256i V;
+
+#define GROUP		32
+
+#define SET1(c)		_mm256_set1_epi8 (c)
+#define XOR(a, b)	_mm256_xor_si256 (a, b)
+#define AND(a, b)	_mm256_and_si256 (a, b)
+#define ADDS8(a, b)	_mm256_adds_epu8 (a, b)
+#define SRL4(a)		_mm256_srli_epi16 (a, 4)
+#define SHUF(t, i)	_mm256_shuffle_epi8 (t, i)
+#define LOADT(p)	_mm256_broadcastsi128_si256 ( \
+				_mm_loadu_si128 ((const void *) (p)))
+
+#define UNPACKLO8(a, b)	_mm256_unpacklo_epi8 (a, b)
+#define UNPACKHI8(a, b)	_mm256_unpackhi_epi8 (a, b)
+
+#define LOAD(p, i)	_mm256_loadu2_m128i ( \
+				(const void *) ((p) + 16 * ((i) + 16)), \
+				(const void *) ((p) + 16 * (i)))
+#define STORE(p, i, x)	_mm256_storeu2_m128i ( \
+				(void *) ((p) + 16 * ((i) + 16)), \
+				(void *) ((p) + 16 * (i)), x)
+
+#define ENCRYPT		kuznechik_encrypt_avx2
+#define DECRYPT		kuznechik_decrypt_avx2
+
+#include "kuznechik-vec.h"
+
+#endif  /* __AVX2__ */
@@ -0,0 +1,71 @@
+/*
+ * Kuznechik Cipher Algorithm: AVX-512 Engine
+ *
+ * Copyright (c) 2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * Standard: GOST R 34.12-2015
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#if defined (__AVX512BW__) && defined (__AVX512VBMI__) && defined (__GFNI__)
+
+#include <immintrin.h>
+
+#include "kuznechik-simd.h"
+#include "kuznechik-tables.h"
+
+/* four groups of 16 blocks, one per 128-bit lane */
+typedef __m512i V;
+
+#define GROUP		64
+
+#define SET1(c)		_mm512_set1_epi8 (c)
+#define XOR(a, b)	_mm512_xor_si512 (a, b)
+
+#define UNPACKLO8(a, b)	_mm512_unpacklo_epi8 (a, b)
+#define UNPACKHI8(a, b)	_mm512_unpackhi_epi8 (a, b)
+
+/* multiplication by a constant is a linear map of bits */
+#define MUL(i, x)	_mm512_gf2p8affine_epi64_epi8 (x, \
+				_mm512_set1_epi64 (kuznechik_lvec_affine[i]), 0)
+
+/* whole S-box fits in four registers: two 128-entry permutations */
+static inline V S_avx512 (const u8 *s, V x)
+{
+	const V lo = _mm512_permutex2var_epi8 (_mm512_loadu_si512 (s), x,
+					       _mm512_loadu_si512 (s + 64));
+	const V hi = _mm512_permutex2var_epi8 (_mm512_loadu_si512 (s + 128), x,
+					       _mm512_loadu_si512 (s + 192));
+
+	return _mm512_mask_blend_epi8 (_mm512_movepi8_mask (x), lo, hi);
+}
+
+#define S_ENC(x)	S_avx512 (sbox, x)
+#define S_DEC(x)	S_avx512 (sbox_inv, x)
+
+static inline V load4 (const u8 *p)
+{
+	V x = _mm512_castsi128_si512 (_mm_loadu_si128 ((const void *) p));
+
+	x = _mm512_inserti32x4 (x, _mm_loadu_si128 ((const void *) (p + 256)), 1);
+	x = _mm512_inserti32x4 (x, _mm_loadu_si128 ((const void *) (p + 512)), 2);
+	return _mm512_inserti32x4 (x, _mm_loadu_si128 ((const void *) (p + 768)), 3);
+}
+
+static inline void store4 (u8 *p, V x)
+{
+	_mm_storeu_si128 ((void *) p,         _mm512_extracti32x4_epi32 (x, 0));
+	_mm_storeu_si128 ((void *) (p + 256), _mm512_extracti32x4_epi32 (x, 1));
+	_mm_storeu_si128 ((void *) (p + 512), _mm512_extracti32x4_epi32 (x, 2));
+	_mm_storeu_si128 ((void *) (p + 768), _mm512_extracti32x4_epi32 (x, 3));
+}
+
+#define LOAD(p, i)	load4 ((p) + 16 * (i))
+#define STORE(p, i, x)	store4 ((p) + 16 * (i), x)
+
+#define ENCRYPT		kuznechik_encrypt_avx512
+#define DECRYPT		kuznechik_decrypt_avx512
+
+#include "kuznechik-vec.h"
+
+#endif
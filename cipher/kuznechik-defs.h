@@ -66,4 +66,56 @@ static const u8 lvec[16] = {
 	148,  32, 133,  16,  194, 192,   1, 251,   1, 192, 194,  16,  133,  32, 148,   1,
 };
 
+/* poly multiplication mod p(x) = x^8 + x^7 + x^6 + x + 1 */
+static inline u8 mul_gf256 (u8 x, u8 y)
+{
+	u8 z;
+
+	for (z = 0; y != 0; y >>= 1) {
+		if (y & 1)
+			z ^= x;
+
+		x = (x << 1) ^ (x & 0x80 ? 0xc3 : 0);
+	}
+
+	return z;
+}
+
+static inline void L (u128 *w)
+{
+	int i, j;
+	u8 x;
+
+	/* 16 rounds */
+	for (j = 0; j < 16; j++) {
+		/* An LFSR with 16 elements from GF(2^8) */
+		x = w->b[15];  /* since lvec[15] = 1 */
+
+		for (i = 14; i >= 0; i--) {
+			w->b[i + 1] = w->b[i];
+			x ^= mul_gf256 (w->b[i], lvec[i]);
+		}
+
+		w->b[0] = x;
+	}
+}
+
+static inline void L_inv (u128 *w)
+{
+	int i, j;
+	u8 x;
+
+	/* 16 rounds */
+	for (j = 0; j < 16; j++) {
+		x = w->b[0];
+
+		for (i = 0; i < 15; i++) {
+			w->b[i] = w->b[i + 1];
+			x ^= mul_gf256 (w->b[i], lvec[i]);
+		}
+
+		w->b[15] = x;
+	}
+}
+
 #endif  /* CRYPTO_KUZNECHIK_DEFS_H */
@@ -0,0 +1,219 @@
+/*
+ * Kuznechik Cipher Algorithm: Table Generator
+ *
+ * Copyright (c) 2016-2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * Standard: GOST R 34.12-2015
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+
+#include "kuznechik-defs.h"
+
+enum table_type { TABLE_SL, TABLE_L_INV, TABLE_S_INV_L_INV };
+
+static void make (enum table_type type, int i, int j, u128 *x)
+{
+	const u128 N0 = {};
+
+	*x = N0;
+
+	switch (type) {
+	case TABLE_SL:
+		x->b[i] = sbox[j];
+		L (x);
+		break;
+	case TABLE_L_INV:
+		x->b[i] = j;
+		L_inv (x);
+		break;
+	case TABLE_S_INV_L_INV:
+		x->b[i] = sbox_inv[j];
+		L_inv (x);
+		break;
+	}
+}
+
+static void gen (const char *name, enum table_type type)
+{
+	int i, j, k;
+	u128 x;
+
+	printf ("\nconst u128 %s[16][256] = {\n", name);
+
+	for (i = 0; i < 16; ++i) {
+		printf ("\t{\n");
+
+		for (j = 0; j < 256; ++j) {
+			make (type, i, j, &x);
+			printf ("\t\t{{");
+
+			for (k = 0; k < 16; ++k)
+				printf ("%s0x%02x", k == 0 ? " " : ", ", x.b[k]);
+
+			printf (" }},\n");
+		}
+
+		printf ("\t},\n");
+	}
+
+	printf ("};\n");
+}
+
+/*
+ * S-box rows telescoped in two halves: row h xor row h + 1, last row of
+ * each half is kept as is
+ */
+static void gen_sbox (const char *name, const u8 *s)
+{
+	int h, n;
+
+	printf ("\nconst u128 %s[16] = {\n", name);
+
+	for (h = 0; h < 16; ++h) {
+		printf ("\t{{");
+
+		for (n = 0; n < 16; ++n)
+			printf ("%s0x%02x", n == 0 ? " " : ", ",
+				s[16 * h + n] ^
+				((h & 7) == 7 ? 0 : s[16 * (h + 1) + n]));
+
+		printf (" }},\n");
+	}
+
+	printf ("};\n");
+}
+
+/* nibble multiplication tables for distinct non-unit coefficients of lvec */
+static void gen_lvec (void)
+{
+	static const u8 c[7] = { 148, 32, 133, 16, 194, 192, 251 };
+	int i, j, n;
+
+	printf ("\nconst u128 kuznechik_lvec_mul[7][2] = {\n");
+
+	for (i = 0; i < 7; ++i) {
+		printf ("\t{  /* %u */\n", c[i]);
+
+		for (j = 0; j < 2; ++j) {
+			printf ("\t\t{{");
+
+			for (n = 0; n < 16; ++n)
+				printf ("%s0x%02x", n == 0 ? " " : ", ",
+					mul_gf256 (c[i], j == 0 ? n : n << 4));
+
+			printf (" }},\n");
+		}
+
+		printf ("\t},\n");
+	}
+
+	printf ("};\n");
+}
+
+/*
+ * Bit matrices of multiplication by lvec coefficients for GF2P8AFFINEQB:
+ * byte 7 - i holds row i, that is the input bits which give output bit i
+ */
+static void gen_affine (void)
+{
+	static const u8 c[7] = { 148, 32, 133, 16, 194, 192, 251 };
+	int k, i, j;
+	u64 a;
+
+	printf ("\nconst u64 kuznechik_lvec_affine[7] = {\n");
+
+	for (k = 0; k < 7; ++k) {
+		for (a = 0, i = 0; i < 8; ++i)
+			for (j = 0; j < 8; ++j)
+				if ((mul_gf256 (c[k], 1 << j) >> i) & 1)
+					a |= (u64) 1 << (8 * (7 - i) + j);
+
+		printf ("\t0x%016llx,  /* %u */\n", (unsigned long long) a,
+			c[k]);
+	}
+
+	printf ("};\n");
+}
+
+/*
+ * Nibble tables for compact backend: [2i + h][n] is L or L^-1 of block with
+ * byte i set to n << 4h, the transform of a block is xor of 32 entries
+ */
+static void gen_nibble (const char *name, int inverse)
+{
+	const u128 N0 = {};
+	int i, n, k;
+	u128 x;
+
+	printf ("\nconst u128 %s[32][16] = {\n", name);
+
+	for (i = 0; i < 32; ++i) {
+		printf ("\t{\n");
+
+		for (n = 0; n < 16; ++n) {
+			x = N0;
+			x.b[i / 2] = n << (4 * (i & 1));
+
+			if (inverse)
+				L_inv (&x);
+			else
+				L (&x);
+
+			printf ("\t\t{{");
+
+			for (k = 0; k < 16; ++k)
+				printf ("%s0x%02x", k == 0 ? " " : ", ", x.b[k]);
+
+			printf (" }},\n");
+		}
+
+		printf ("\t},\n");
+	}
+
+	printf ("};\n");
+}
+
+/* key schedule round constants C[i - 1] = L (i) for i = 1 .. 32 */
+static void gen_consts (void)
+{
+	const u128 N0 = {};
+	int i, n;
+	u128 C;
+
+	printf ("\nconst u128 kuznechik_C[32] = {\n");
+
+	for (i = 1; i <= 32; ++i) {
+		C = N0;
+		C.b[15] = i;  /* Big Endian number */
+		L (&C);
+
+		printf ("\t{{");
+
+		for (n = 0; n < 16; ++n)
+			printf ("%s0x%02x", n == 0 ? " " : ", ", C.b[n]);
+
+		printf (" }},\n");
+	}
+
+	printf ("};\n");
+}
+
+int main (void)
+{
+	printf ("/* generated by kuznechik-gen, do not edit */\n\n"
+		"#include \"kuznechik-tables.h\"\n");
+
+	gen ("kuznechik_SL",          TABLE_SL);
+	gen ("kuznechik_L_inv",       TABLE_L_INV);
+	gen ("kuznechik_S_inv_L_inv", TABLE_S_INV_L_INV);
+	gen_sbox ("kuznechik_sbox_diff", sbox);
+	gen_sbox ("kuznechik_sbox_inv_diff", sbox_inv);
+	gen_lvec ();
+	gen_affine ();
+	gen_nibble ("kuznechik_L_nibble", 0);
+	gen_nibble ("kuznechik_L_inv_nibble", 1);
+	gen_consts ();
+	return 0;
+}
@@ -0,0 +1,34 @@
+/*
+ * Kuznechik Cipher Algorithm: Vector Engines
+ *
+ * Copyright (c) 2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * Standard: GOST R 34.12-2015
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef CRYPTO_KUZNECHIK_SIMD_H
+#define CRYPTO_KUZNECHIK_SIMD_H  1
+
+#include "kuznechik-defs.h"
+
+/*
+ * Process whole groups of 16 (SSSE3), 32 (AVX2) or 64 (AVX-512) blocks with
+ * round keys k, returns number of blocks processed.
+ */
+size_t kuznechik_encrypt_ssse3 (const u128 k[10], const void *in, void *out,
+				size_t count);
+size_t kuznechik_decrypt_ssse3 (const u128 k[10], const void *in, void *out,
+				size_t count);
+
+size_t kuznechik_encrypt_avx2 (const u128 k[10], const void *in, void *out,
+			       size_t count);
+size_t kuznechik_decrypt_avx2 (const u128 k[10], const void *in, void *out,
+			       size_t count);
+
+size_t kuznechik_encrypt_avx512 (const u128 k[10], const void *in, void *out,
+				 size_t count);
+size_t kuznechik_decrypt_avx512 (const u128 k[10], const void *in, void *out,
+				 size_t count);
+
+#endif  /* CRYPTO_KUZNECHIK_SIMD_H */
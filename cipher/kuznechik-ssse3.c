@@ -0,0 +1,39 @@
+/*
+ * Kuznechik Cipher Algorithm: SSSE3 Engine
+ *
+ * Copyright (c) 2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * Standard: GOST R 34.12-2015
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifdef __SSSE3__
+
+#include <tmmintrin.h>
+
+#include "kuznechik-simd.h"
+
+typedef __m128i V;
+
+#define GROUP		16
+
+#define SET1(c)		_mm_set1_epi8 (c)
+#define XOR(a, b)	_mm_xor_si128 (a, b)
+#define AND(a, b)	_mm_and_si128 (a, b)
+#define ADDS8(a, b)	_mm_adds_epu8 (a, b)
+#define SRL4(a)		_mm_srli_epi16 (a, 4)
+#define SHUF(t, i)	_mm_shuffle_epi8 (t, i)
+#define LOADT(p)	_mm_loadu_si128 ((const void *) (p))
+
+#define UNPACKLO8(a, b)	_mm_unpacklo_epi8 (a, b)
+#define UNPACKHI8(a, b)	_mm_unpackhi_epi8 (a, b)
+
+#define LOAD(p, i)	_mm_loadu_si128 ((const void *) ((p) + 16 * (i)))
+#define STORE(p, i, x)	_mm_storeu_si128 ((void *) ((p) + 16 * (i)), x)
+
+#define ENCRYPT		kuznechik_encrypt_ssse3
+#define DECRYPT		kuznechik_decrypt_ssse3
+
+#include "kuznechik-vec.h"
+
+#endif  /* __SSSE3__ */
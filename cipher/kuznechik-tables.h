@@ -0,0 +1,46 @@
+/*
+ * Kuznechik Cipher Algorithm: Precomputed Tables
+ *
+ * Copyright (c) 2016-2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * Standard: GOST R 34.12-2015
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef CRYPTO_KUZNECHIK_TABLES_H
+#define CRYPTO_KUZNECHIK_TABLES_H  1
+
+#include "kuznechik-defs.h"
+
+/* generated at build time by kuznechik-gen into kuznechik-tables.c */
+extern const u128 kuznechik_SL[16][256];
+extern const u128 kuznechik_L_inv[16][256];
+extern const u128 kuznechik_S_inv_L_inv[16][256];
+
+/*
+ * S-box rows for vector lookup: row h is xor of S-box rows h and h + 1,
+ * rows 7 and 15 are S-box rows as is
+ */
+extern const u128 kuznechik_sbox_diff[16];
+extern const u128 kuznechik_sbox_inv_diff[16];
+
+/*
+ * Nibble multiplication tables: [i][0][n] = c[i] * n, [i][1][n] = c[i] * 16n
+ * for lvec coefficients c = { 148, 32, 133, 16, 194, 192, 251 }
+ */
+extern const u128 kuznechik_lvec_mul[7][2];
+
+/* GF2P8AFFINEQB bit matrices of multiplication by the same coefficients */
+extern const u64 kuznechik_lvec_affine[7];
+
+/*
+ * Compact L and L^-1 tables, 8 KiB each: [2i][n] and [2i + 1][n] are
+ * transforms of block with byte i set to n and n << 4 respectively
+ */
+extern const u128 kuznechik_L_nibble[32][16];
+extern const u128 kuznechik_L_inv_nibble[32][16];
+
+/* key schedule round constants: C[i - 1] = L (i) */
+extern const u128 kuznechik_C[32];
+
+#endif  /* CRYPTO_KUZNECHIK_TABLES_H */
@@ -0,0 +1,207 @@
+/*
+ * Kuznechik Cipher Algorithm: Byte-Sliced Vector Engine
+ *
+ * Copyright (c) 2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * Standard: GOST R 34.12-2015
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/*
+ * This file is a template included by ISA-specific modules, they define
+ * vector type V holding byte i of GROUP blocks, primitives below and names
+ * of entry points ENCRYPT and DECRYPT. A module may provide multiplication
+ * by i-th distinct lvec coefficient MUL (i, x) and S-box layers S_ENC (x)
+ * and S_DEC (x) of its own, pshufb lookups are used otherwise.
+ *
+ * A group of blocks is transposed so that x[i] holds byte i of every block
+ * of the group, thus the byte rotation of R is a register renaming, and S
+ * and multiplication in GF(2^8) are done within registers: no memory access
+ * depends on data.
+ */
+
+#include "kuznechik-tables.h"
+
+/* b[i] = x[(i + o) & 15], pairs of bytes with equal lvec coefficient share
+   multiplication: sum of lvec[i] * b[i] for i = 0 .. 14 */
+#define B(i)  x[((i) + o) & 15]
+
+#ifndef MUL
+static inline always_inline V mul (const u128 t[2], V x)
+{
+	const V m = SET1 (0x0f);
+
+	return XOR (SHUF (LOADT (t[0].b), AND (x, m)),
+		    SHUF (LOADT (t[1].b), AND (SRL4 (x), m)));
+}
+
+#define MUL(i, x)  mul (kuznechik_lvec_mul[i], x)
+#endif
+
+static inline always_inline V lsum (const V *x, int o)
+{
+	V y;
+
+	y = MUL (0, XOR (B (0), B (14)));
+	y = XOR (y, MUL (1, XOR (B (1), B (13))));
+	y = XOR (y, MUL (2, XOR (B (2), B (12))));
+	y = XOR (y, MUL (3, XOR (B (3), B (11))));
+	y = XOR (y, MUL (4, XOR (B (4), B (10))));
+	y = XOR (y, MUL (5, XOR (B (5), B  (9))));
+	y = XOR (y, XOR (B (6), B (8)));
+	y = XOR (y, MUL (6, B (7)));
+	return y;
+}
+
+#undef B
+
+static inline always_inline void L_vec (V x[16])
+{
+	int t;
+
+	/* new b[0] = b[15] ^ lsum (b[0 .. 14]) takes the place of b[15] */
+#pragma GCC unroll 16
+	for (t = 0; t < 16; ++t)
+		x[(15 - t) & 15] = XOR (x[(15 - t) & 15], lsum (x, -t));
+}
+
+static inline always_inline void L_inv_vec (V x[16])
+{
+	int t;
+
+	/* new b[15] = b[0] ^ lsum (b[1 .. 15]) takes the place of b[0] */
+#pragma GCC unroll 16
+	for (t = 0; t < 16; ++t)
+		x[t & 15] = XOR (x[t & 15], lsum (x, t + 1));
+}
+
+#ifndef S_ENC
+/*
+ * Add 0x70 - 16h with saturation: bit 7 of result is clear iff high nibble
+ * of x is not above h, thus pshufb selects rows h .. 7 of telescoped table
+ * and their sum is S-box row of x. Upper half of S-box is processed in the
+ * same way with high bit of x inverted.
+ */
+static inline always_inline V S_vec (const u128 *s, V x)
+{
+	const V y = XOR (x, SET1 (0x80));
+	V z = XOR (SHUF (LOADT (s[7].b), x), SHUF (LOADT (s[15].b), y));
+	int h;
+
+#pragma GCC unroll 8
+	for (h = 0; h < 7; ++h) {
+		const V c = SET1 (0x70 - 16 * h);
+
+		z = XOR (z, SHUF (LOADT (s[h].b),     ADDS8 (x, c)));
+		z = XOR (z, SHUF (LOADT (s[h + 8].b), ADDS8 (y, c)));
+	}
+
+	return z;
+}
+
+#define S_ENC(x)  S_vec (kuznechik_sbox_diff, x)
+#define S_DEC(x)  S_vec (kuznechik_sbox_inv_diff, x)
+#endif
+
+static inline always_inline void X_vec (const u128 *k, V x[16])
+{
+	int i;
+
+#pragma GCC unroll 16
+	for (i = 0; i < 16; ++i)
+		x[i] = XOR (x[i], SET1 (k->b[i]));
+}
+
+/* 16 x 16 byte transposition is its own inverse */
+static inline always_inline void transpose (V x[16])
+{
+	V t[16];
+	int r, i;
+
+	for (r = 0; r < 4; ++r) {
+		for (i = 0; i < 8; ++i) {
+			t[2 * i]     = UNPACKLO8 (x[i], x[i + 8]);
+			t[2 * i + 1] = UNPACKHI8 (x[i], x[i + 8]);
+		}
+
+		for (i = 0; i < 16; ++i)
+			x[i] = t[i];
+	}
+}
+
+static void encrypt_group (const u128 *k, const u8 *in, u8 *out)
+{
+	V x[16];
+	int i, r;
+
+	for (i = 0; i < 16; ++i)
+		x[i] = LOAD (in, i);
+
+	transpose (x);
+	X_vec (k, x);
+
+	for (r = 1; r <= 9; ++r) {
+		for (i = 0; i < 16; ++i)
+			x[i] = S_ENC (x[i]);
+
+		L_vec (x);
+		X_vec (k + r, x);
+	}
+
+	transpose (x);
+
+	for (i = 0; i < 16; ++i)
+		STORE (out, i, x[i]);
+}
+
+static void decrypt_group (const u128 *k, const u8 *in, u8 *out)
+{
+	V x[16];
+	int i, r;
+
+	for (i = 0; i < 16; ++i)
+		x[i] = LOAD (in, i);
+
+	transpose (x);
+	X_vec (k + 9, x);
+
+	for (r = 8; r >= 0; --r) {
+		L_inv_vec (x);
+
+		for (i = 0; i < 16; ++i)
+			x[i] = S_DEC (x[i]);
+
+		X_vec (k + r, x);
+	}
+
+	transpose (x);
+
+	for (i = 0; i < 16; ++i)
+		STORE (out, i, x[i]);
+}
+
+size_t ENCRYPT (const u128 k[10], const void *src, void *dst, size_t count)
+{
+	const size_t n = count / GROUP * GROUP;
+	const u8 *in = src;
+	u8 *out = dst;
+
+	for (count = n; count > 0; count -= GROUP, in += GROUP * 16,
+					       out += GROUP * 16)
+		encrypt_group (k, in, out);
+
+	return n;
+}
+
+size_t DECRYPT (const u128 k[10], const void *src, void *dst, size_t count)
+{
+	const size_t n = count / GROUP * GROUP;
+	const u8 *in = src;
+	u8 *out = dst;
+
+	for (count = n; count > 0; count -= GROUP, in += GROUP * 16,
+					       out += GROUP * 16)
+		decrypt_group (k, in, out);
+
+	return n;
+}
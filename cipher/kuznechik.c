@@ -8,24 +8,41 @@
  */
 
 #include <errno.h>
+#include <stddef.h>
 #include <string.h>
 
+#include <crypto/cpu.h>
+#include <crypto/key-cache.h>
 #include <crypto/utils.h>
 
 #include <cipher/kuznechik.h>
 
 #include "kuznechik-defs.h"
+#include "kuznechik-simd.h"
+#include "kuznechik-tables.h"
+
+/* number of blocks in flight for multi-block table path */
+#ifndef KUZNECHIK_WAY
+#define KUZNECHIK_WAY	4
+#endif
 
 struct state {
 	struct crypto crypto;
 	u128 k[10];	/* round keys */
-	u128 kd[10];	/* decryption keys */
+	u128 kd[10];	/* decryption keys, derived with round keys */
 };
 
+/* encrypt-only state ends before decryption keys */
+#define ENC_SIZE  offsetof (struct state, kd)
+
+static size_t state_size (const struct state *o)
+{
+	return o->crypto.core->size;
+}
+
 static void kuznechik_reset (struct state *o)
 {
-	memset_secure (o->k,  0, sizeof (o->k));
-	memset_secure (o->kd, 0, sizeof (o->k));
+	memset_secure (o->k, 0, state_size (o) - offsetof (struct state, k));
 }
 
 static void S (u128 *x)
@@ -44,58 +61,6 @@ static void S_inv (u128 *x)
 		x->b[i] = sbox_inv[x->b[i]];
 }
 
-/* poly multiplication mod p(x) = x^8 + x^7 + x^6 + x + 1 */
-static u8 mul_gf256 (u8 x, u8 y)
-{
-	u8 z;
-
-	for (z = 0; y != 0; y >>= 1) {
-		if (y & 1)
-			z ^= x;
-
-		x = (x << 1) ^ (x & 0x80 ? 0xc3 : 0);
-	}
-
-	return z;
-}
-
-static void L (u128 *w)
-{
-	int i, j;
-	u8 x;
-
-	/* 16 rounds */
-	for (j = 0; j < 16; j++) {
-		/* An LFSR with 16 elements from GF(2^8) */
-		x = w->b[15];  /* since lvec[15] = 1 */
-
-		for (i = 14; i >= 0; i--) {
-			w->b[i + 1] = w->b[i];
-			x ^= mul_gf256 (w->b[i], lvec[i]);
-		}
-
-		w->b[0] = x;
-	}
-}
-
-static void L_inv (u128 *w)
-{
-	int i, j;
-	u8 x;
-
-	/* 16 rounds */
-	for (j = 0; j < 16; j++) {
-		x = w->b[0];
-
-		for (i = 0; i < 15; i++) {
-			w->b[i] = w->b[i + 1];
-			x ^= mul_gf256 (w->b[i], lvec[i]);
-		}
-
-		w->b[15] = x;
-	}
-}
-
 static void xor128 (const u128 *a, const u128 *b, u128 *out)
 {
 #ifdef __SSE__
@@ -106,54 +71,13 @@ static void xor128 (const u128 *a, const u128 *b, u128 *out)
 #endif
 }
 
-static u128 table_SL[16][256];
-static u128 table_L_inv[16][256];
-static u128 table_S_inv_L_inv[16][256];
-
-static void init_tables (void)
-{
-	static int done;
-	int i, j;
-	const u128 N0 = {};
-	u128 x;
-
-	if (done)
-		return;
-
-	for (i = 0; i < 16; i++)
-		for (j = 0; j < 256; j++) {
-			x = N0;
-			x.b[i] = sbox[j];
-			L (&x);
-			table_SL[i][j] = x;
-
-			x = N0;
-			x.b[i] = j;
-			L_inv (&x);
-			table_L_inv[i][j] = x;
-
-			x = N0;
-			x.b[i] = sbox_inv[j];
-			L_inv (&x);
-			table_S_inv_L_inv[i][j] = x;
-		}
-
-	done = 1;
-}
-
-static int set_key (struct state *c, va_list ap)
+/* reference key schedule, no tables */
+static void expand_key_ref (struct state *c, const void *key)
 {
-	const void *key = va_arg (ap, const void *);
-	size_t len = va_arg (ap, size_t);
 	int i;
 	const u128 N0 = {};
 	u128 C, x, y, z;
 
-	init_tables ();
-
-	if (len != 32)
-		return -EINVAL;
-
 	memcpy (&x, key, 16);
 	memcpy (&y, key + 16, 16);
 
@@ -178,20 +102,24 @@ static int set_key (struct state *c, va_list ap)
 			c->k[(i >> 2) + 1] = y;
 		}
 	}
+}
 
-	/* set decryption keys */
-	c->kd[0] = c->k[0];
+static int set_key (struct state *c, va_list ap,
+		    void (*expand) (struct state *c, const void *key))
+{
+	const void *key = va_arg (ap, const void *);
+	size_t len = va_arg (ap, size_t);
 
-	for (i = 1; i < 10; i++) {
-		c->kd[i] = c->k[i];
-		L_inv (&c->kd[i]);
-	}
+	if (len != 32)
+		return -EINVAL;
 
+	expand (c, key);
 	return 0;
 }
 
-#ifdef NO_TABLES
-static void encrypt (void *state, const void *in, void *out)
+/* reference backend, no tables */
+
+static void encrypt_ref (void *state, const void *in, void *out)
 {
 	struct state *c = state;
 	int i;
@@ -210,7 +138,7 @@ static void encrypt (void *state, const void *in, void *out)
 	memcpy (out, &x, sizeof (x));
 }
 
-static void decrypt (void *state, const void *in, void *out)
+static void decrypt_ref (void *state, const void *in, void *out)
 {
 	struct state *c = state;
 	int i;
@@ -228,9 +156,31 @@ static void decrypt (void *state, const void *in, void *out)
 
 	memcpy (out, &x, sizeof (x));
 }
-#else
+
+static void encrypt_n_ref (void *state, const void *src, void *dst,
+			   size_t count)
+{
+	const u8 *in = src;
+	u8 *out = dst;
+
+	for (; count > 0; --count, in += 16, out += 16)
+		encrypt_ref (state, in, out);
+}
+
+static void decrypt_n_ref (void *state, const void *src, void *dst,
+			   size_t count)
+{
+	const u8 *in = src;
+	u8 *out = dst;
+
+	for (; count > 0; --count, in += 16, out += 16)
+		decrypt_ref (state, in, out);
+}
+
+/* table backend */
+
 /* WARNING: in and out should not overlap */
-static void table_it (u128 table[16][256], const u128 *in, u128 *out)
+static void table_it (const u128 table[16][256], const u128 *in, u128 *out)
 {
 	int i;
 
@@ -240,6 +190,59 @@ static void table_it (u128 table[16][256], const u128 *in, u128 *out)
 		xor128 (out, &table[i][in->b[i]], out);
 }
 
+/* key schedule with precomputed round constants and LS tables */
+static void expand_key (struct state *c, const void *key)
+{
+	int i;
+	u128 x, y, z, t;
+
+	/* all backends share round key layout */
+	if (crypto_key_cache_lookup (&kuznechik_core, NULL, key, 32,
+				     c->k, sizeof (c->k)))
+		return;
+
+	memcpy (&x, key, 16);
+	memcpy (&y, key + 16, 16);
+
+	c->k[0] = x;
+	c->k[1] = y;
+
+	for (i = 1; i <= 32; i++) {
+		xor128 (&x, &kuznechik_C[i - 1], &t);
+		table_it (kuznechik_SL, &t, &z);
+		xor128 (&z, &y, &z);
+
+		y = x;
+		x = z;
+
+		if ((i & 7) == 0) {
+			c->k[(i >> 2)]     = x;
+			c->k[(i >> 2) + 1] = y;
+		}
+	}
+
+	crypto_key_cache_store (&kuznechik_core, NULL, key, 32,
+				c->k, sizeof (c->k));
+}
+
+/*
+ * Decryption keys are derived with round keys, thus keyed state is never
+ * written by decrypt and can be shared between threads. Encrypt-only cores
+ * have no room for them.
+ */
+static void expand_dec_key (struct state *c)
+{
+	int i;
+
+	if (state_size (c) <= ENC_SIZE)
+		return;
+
+	c->kd[0] = c->k[0];
+
+	for (i = 1; i < 10; i++)
+		table_it (kuznechik_L_inv, &c->k[i], &c->kd[i]);
+}
+
 static void encrypt (void *state, const void *in, void *out)
 {
 	struct state *c = state;
@@ -251,7 +254,7 @@ static void encrypt (void *state, const void *in, void *out)
 	xor128 (&x, &c->k[0], &x);
 
 	for (i = 1; i <= 9; i++) {
-		table_it (table_SL, &x, &y);
+		table_it (kuznechik_SL, &x, &y);
 		xor128 (&y, &c->k[i], &x);
 	}
 
@@ -266,11 +269,11 @@ static void decrypt (void *state, const void *in, void *out)
 
 	memcpy (&x, in, sizeof (x));
 
-	table_it (table_L_inv, &x, &y);
+	table_it (kuznechik_L_inv, &x, &y);
 	xor128 (&y, &c->kd[9], &x);
 
 	for (i = 8; i > 0; --i) {
-		table_it (table_S_inv_L_inv, &x, &y);
+		table_it (kuznechik_S_inv_L_inv, &x, &y);
 		xor128 (&y, &c->kd[i], &x);
 	}
 
@@ -279,48 +282,541 @@ static void decrypt (void *state, const void *in, void *out)
 
 	memcpy (out, &x, sizeof (x));
 }
-#endif  /* !NO_TABLES */
 
-static void *alloc (void)
+/*
+ * Interleaved table path: a single block is a chain of dependent lookups,
+ * so several independent blocks are passed through every round together
+ * to hide latency of table loads. The way is a constant once inlined.
+ */
+static inline always_inline
+void table_way (const u128 table[16][256], const u128 *in, u128 *out,
+		const int way)
+{
+	int i, j;
+
+#pragma GCC unroll 8
+	for (j = 0; j < way; ++j)
+		out[j] = table[0][in[j].b[0]];
+
+#pragma GCC unroll 16
+	for (i = 1; i < 16; ++i)
+#pragma GCC unroll 8
+		for (j = 0; j < way; ++j)
+			xor128 (out + j, &table[i][in[j].b[i]], out + j);
+}
+
+static inline always_inline
+void xor_way (const u128 *x, const u128 *k, u128 *out, const int way)
 {
-	return calloc (1, sizeof (struct state));
+	int j;
+
+#pragma GCC unroll 8
+	for (j = 0; j < way; ++j)
+		xor128 (x + j, k, out + j);
 }
 
-static void kuznechik_free (void *state)
+static inline always_inline
+void encrypt_way (struct state *c, const u8 *in, u8 *out, const int way)
 {
-	kuznechik_reset (state);
-	free (state);
+	u128 x[KUZNECHIK_WAY], y[KUZNECHIK_WAY];
+	int i;
+
+	memcpy (x, in, way * 16);
+	xor_way (x, &c->k[0], x, way);
+
+	for (i = 1; i <= 9; i++) {
+		table_way (kuznechik_SL, x, y, way);
+		xor_way (y, &c->k[i], x, way);
+	}
+
+	memcpy (out, x, way * 16);
 }
 
-static int get (const void *state, int type, va_list ap)
+static inline always_inline
+void decrypt_way (struct state *c, const u8 *in, u8 *out, const int way)
 {
-	switch (type) {
-	case CRYPTO_BLOCK_SIZE:	return 16;
+	u128 x[KUZNECHIK_WAY], y[KUZNECHIK_WAY];
+	int i, j;
+
+	memcpy (x, in, way * 16);
+	table_way (kuznechik_L_inv, x, y, way);
+	xor_way (y, &c->kd[9], x, way);
+
+	for (i = 8; i > 0; --i) {
+		table_way (kuznechik_S_inv_L_inv, x, y, way);
+		xor_way (y, &c->kd[i], x, way);
 	}
 
-	return -ENOSYS;
+	for (j = 0; j < way; ++j)
+		S_inv (x + j);
+
+	xor_way (x, &c->kd[0], x, way);
+	memcpy (out, x, way * 16);
+}
+
+static void encrypt_n (void *state, const void *src, void *dst, size_t count)
+{
+	const u8 *in = src;
+	u8 *out = dst;
+
+	for (; count >= KUZNECHIK_WAY; count -= KUZNECHIK_WAY,
+	       in += KUZNECHIK_WAY * 16, out += KUZNECHIK_WAY * 16)
+		encrypt_way (state, in, out, KUZNECHIK_WAY);
+
+	for (; count > 0; --count, in += 16, out += 16)
+		encrypt (state, in, out);
+}
+
+static void decrypt_n (void *state, const void *src, void *dst, size_t count)
+{
+	const u8 *in = src;
+	u8 *out = dst;
+
+	for (; count >= KUZNECHIK_WAY; count -= KUZNECHIK_WAY,
+	       in += KUZNECHIK_WAY * 16, out += KUZNECHIK_WAY * 16)
+		decrypt_way (state, in, out, KUZNECHIK_WAY);
+
+	for (; count > 0; --count, in += 16, out += 16)
+		decrypt (state, in, out);
+}
+
+/*
+ * Compact backend: byte S-box followed by L from 16-entry nibble tables,
+ * 8 KiB per direction instead of 64 KiB of combined LS tables. Slower
+ * when tables stay in cache, but a cold start costs much less.
+ */
+static inline always_inline
+void nibble_way (const u128 T[32][16], const u8 *s, const u128 *in,
+		 u128 *out, const int way)
+{
+	const u128 N0 = {};
+	int i, j;
+	u8 x;
+
+#pragma GCC unroll 8
+	for (j = 0; j < way; ++j)
+		out[j] = N0;
+
+#pragma GCC unroll 16
+	for (i = 0; i < 16; ++i)
+#pragma GCC unroll 8
+		for (j = 0; j < way; ++j) {
+			x = s == NULL ? in[j].b[i] : s[in[j].b[i]];
+			xor128 (out + j, &T[2 * i][x & 15], out + j);
+			xor128 (out + j, &T[2 * i + 1][x >> 4], out + j);
+		}
+}
+
+static inline always_inline
+void encrypt_compact_way (struct state *c, const u8 *in, u8 *out,
+			  const int way)
+{
+	u128 x[KUZNECHIK_WAY], y[KUZNECHIK_WAY];
+	int i;
+
+	memcpy (x, in, way * 16);
+	xor_way (x, &c->k[0], x, way);
+
+	for (i = 1; i <= 9; i++) {
+		nibble_way (kuznechik_L_nibble, sbox, x, y, way);
+		xor_way (y, &c->k[i], x, way);
+	}
+
+	memcpy (out, x, way * 16);
+}
+
+static inline always_inline
+void decrypt_compact_way (struct state *c, const u8 *in, u8 *out,
+			  const int way)
+{
+	u128 x[KUZNECHIK_WAY], y[KUZNECHIK_WAY];
+	int i, j;
+
+	memcpy (x, in, way * 16);
+	nibble_way (kuznechik_L_inv_nibble, NULL, x, y, way);
+	xor_way (y, &c->kd[9], x, way);
+
+	for (i = 8; i > 0; --i) {
+		nibble_way (kuznechik_L_inv_nibble, sbox_inv, x, y, way);
+		xor_way (y, &c->kd[i], x, way);
+	}
+
+	for (j = 0; j < way; ++j)
+		S_inv (x + j);
+
+	xor_way (x, &c->kd[0], x, way);
+	memcpy (out, x, way * 16);
+}
+
+static void encrypt_compact (void *state, const void *in, void *out)
+{
+	encrypt_compact_way (state, in, out, 1);
+}
+
+static void decrypt_compact (void *state, const void *in, void *out)
+{
+	decrypt_compact_way (state, in, out, 1);
+}
+
+static void encrypt_n_compact (void *state, const void *src, void *dst,
+			       size_t count)
+{
+	const u8 *in = src;
+	u8 *out = dst;
+
+	for (; count >= KUZNECHIK_WAY; count -= KUZNECHIK_WAY,
+	       in += KUZNECHIK_WAY * 16, out += KUZNECHIK_WAY * 16)
+		encrypt_compact_way (state, in, out, KUZNECHIK_WAY);
+
+	for (; count > 0; --count, in += 16, out += 16)
+		encrypt_compact_way (state, in, out, 1);
+}
+
+static void decrypt_n_compact (void *state, const void *src, void *dst,
+			       size_t count)
+{
+	const u8 *in = src;
+	u8 *out = dst;
+
+	for (; count >= KUZNECHIK_WAY; count -= KUZNECHIK_WAY,
+	       in += KUZNECHIK_WAY * 16, out += KUZNECHIK_WAY * 16)
+		decrypt_compact_way (state, in, out, KUZNECHIK_WAY);
+
+	for (; count > 0; --count, in += 16, out += 16)
+		decrypt_compact_way (state, in, out, 1);
+}
+
+/* key schedule of compact backend, the large LS tables are not touched */
+static void expand_key_compact (struct state *c, const void *key)
+{
+	int i;
+	u128 x, y, z, t;
+
+	if (crypto_key_cache_lookup (&kuznechik_core, NULL, key, 32,
+				     c->k, sizeof (c->k)))
+		return;
+
+	memcpy (&x, key, 16);
+	memcpy (&y, key + 16, 16);
+
+	c->k[0] = x;
+	c->k[1] = y;
+
+	for (i = 1; i <= 32; i++) {
+		xor128 (&x, &kuznechik_C[i - 1], &t);
+		nibble_way (kuznechik_L_nibble, sbox, &t, &z, 1);
+		xor128 (&z, &y, &z);
+
+		y = x;
+		x = z;
+
+		if ((i & 7) == 0) {
+			c->k[(i >> 2)]     = x;
+			c->k[(i >> 2) + 1] = y;
+		}
+	}
+
+	crypto_key_cache_store (&kuznechik_core, NULL, key, 32,
+				c->k, sizeof (c->k));
+}
+
+static void expand_dec_key_compact (struct state *c)
+{
+	int i;
+
+	if (state_size (c) <= ENC_SIZE)
+		return;
+
+	c->kd[0] = c->k[0];
+
+	for (i = 1; i < 10; i++)
+		nibble_way (kuznechik_L_inv_nibble, NULL, &c->k[i], &c->kd[i],
+			    1);
+}
+
+#ifdef CRYPTO_CPU_X86
+
+/*
+ * Vector backends: whole groups of blocks are processed by vector engine,
+ * the rest and single blocks go to the table path. A padded group costs
+ * more than 16 blocks done with tables.
+ */
+static void encrypt_n_ssse3 (void *state, const void *src, void *dst,
+			     size_t count)
+{
+	struct state *c = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t n = kuznechik_encrypt_ssse3 (c->k, in, out, count);
+
+	encrypt_n (c, in + n * 16, out + n * 16, count - n);
+}
+
+static void decrypt_n_ssse3 (void *state, const void *src, void *dst,
+			     size_t count)
+{
+	struct state *c = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t n = kuznechik_decrypt_ssse3 (c->k, in, out, count);
+
+	decrypt_n (c, in + n * 16, out + n * 16, count - n);
+}
+
+static void encrypt_n_avx2 (void *state, const void *src, void *dst,
+			    size_t count)
+{
+	struct state *c = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t n = kuznechik_encrypt_avx2 (c->k, in, out, count);
+
+	encrypt_n_ssse3 (c, in + n * 16, out + n * 16, count - n);
+}
+
+static void decrypt_n_avx2 (void *state, const void *src, void *dst,
+			    size_t count)
+{
+	struct state *c = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t n = kuznechik_decrypt_avx2 (c->k, in, out, count);
+
+	decrypt_n_ssse3 (c, in + n * 16, out + n * 16, count - n);
+}
+
+/*
+ * Bulk calls of 64 blocks and more go to constant-time AVX-512 engine, it
+ * beats the table path, small calls and the rest keep the table path.
+ */
+static void encrypt_n_avx512 (void *state, const void *src, void *dst,
+			      size_t count)
+{
+	struct state *c = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t n = kuznechik_encrypt_avx512 (c->k, in, out, count);
+
+	encrypt_n (c, in + n * 16, out + n * 16, count - n);
+}
+
+static void decrypt_n_avx512 (void *state, const void *src, void *dst,
+			      size_t count)
+{
+	struct state *c = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t n = kuznechik_decrypt_avx512 (c->k, in, out, count);
+
+	decrypt_n (c, in + n * 16, out + n * 16, count - n);
+}
+
+#endif  /* CRYPTO_CPU_X86 */
+
+static void kuznechik_init (void *state)
+{
+	kuznechik_reset (state);
+}
+
+static void kuznechik_fini (void *state)
+{
+	kuznechik_reset (state);
+}
+
+static int kuznechik_clone (void *state, const void *from)
+{
+	memcpy (state, from, state_size (from));
+	return 0;
 }
 
 static int set (void *state, int type, va_list ap)
 {
+	int ret;
+
 	switch (type) {
 	case CRYPTO_RESET:
 		kuznechik_reset (state);
 		return 0;
 	case CRYPTO_KEY:
-		return set_key (state, ap);
+		if ((ret = set_key (state, ap, expand_key)) == 0)
+			expand_dec_key (state);
+
+		return ret;
 	}
 
 	return -ENOSYS;
 }
 
+static int set_compact (void *state, int type, va_list ap)
+{
+	int ret;
+
+	switch (type) {
+	case CRYPTO_KEY:
+		if ((ret = set_key (state, ap, expand_key_compact)) == 0)
+			expand_dec_key_compact (state);
+
+		return ret;
+	}
+
+	return set (state, type, ap);
+}
+
+static int set_ref (void *state, int type, va_list ap)
+{
+	switch (type) {
+	case CRYPTO_KEY:
+		return set_key (state, ap, expand_key_ref);
+	}
+
+	return set (state, type, ap);
+}
+
 const struct crypto_core kuznechik_core = {
-	.alloc		= alloc,
-	.free		= kuznechik_free,
+	.size		= sizeof (struct state),
+	.block_size	= 16,
+
+	.init		= kuznechik_init,
+	.fini		= kuznechik_fini,
+	.clone		= kuznechik_clone,
+
+	.set		= set,
+
+	.encrypt	= encrypt,
+	.decrypt	= decrypt,
+
+	.encrypt_n	= encrypt_n,
+	.decrypt_n	= decrypt_n,
+};
+
+/* encrypt-only table backend for CTR, OFB, CFB and CMAC, no decryption keys */
+const struct crypto_core kuznechik_enc_core = {
+	.size		= ENC_SIZE,
+	.block_size	= 16,
+
+	.init		= kuznechik_init,
+	.fini		= kuznechik_fini,
+	.clone		= kuznechik_clone,
+
+	.set		= set,
+
+	.encrypt	= encrypt,
+	.encrypt_n	= encrypt_n,
+};
+
+const struct crypto_core kuznechik_compact_core = {
+	.size		= sizeof (struct state),
+	.block_size	= 16,
+
+	.init		= kuznechik_init,
+	.fini		= kuznechik_fini,
+	.clone		= kuznechik_clone,
+
+	.set		= set_compact,
+
+	.encrypt	= encrypt_compact,
+	.decrypt	= decrypt_compact,
+
+	.encrypt_n	= encrypt_n_compact,
+	.decrypt_n	= decrypt_n_compact,
+};
+
+const struct crypto_core kuznechik_enc_compact_core = {
+	.size		= ENC_SIZE,
+	.block_size	= 16,
+
+	.init		= kuznechik_init,
+	.fini		= kuznechik_fini,
+	.clone		= kuznechik_clone,
+
+	.set		= set_compact,
+
+	.encrypt	= encrypt_compact,
+	.encrypt_n	= encrypt_n_compact,
+};
+
+const struct crypto_core kuznechik_ref_core = {
+	.size		= sizeof (struct state),
+	.block_size	= 16,
+
+	.init		= kuznechik_init,
+	.fini		= kuznechik_fini,
+	.clone		= kuznechik_clone,
+
+	.set		= set_ref,
+
+	.encrypt	= encrypt_ref,
+	.decrypt	= decrypt_ref,
+
+	.encrypt_n	= encrypt_n_ref,
+	.decrypt_n	= decrypt_n_ref,
+};
+
+#ifdef CRYPTO_CPU_X86
+
+const struct crypto_core kuznechik_ssse3_core = {
+	.size		= sizeof (struct state),
+	.block_size	= 16,
+
+	.init		= kuznechik_init,
+	.fini		= kuznechik_fini,
+	.clone		= kuznechik_clone,
+
+	.set		= set,
+
+	.encrypt	= encrypt,
+	.decrypt	= decrypt,
+
+	.encrypt_n	= encrypt_n_ssse3,
+	.decrypt_n	= decrypt_n_ssse3,
+};
+
+const struct crypto_core kuznechik_avx2_core = {
+	.size		= sizeof (struct state),
+	.block_size	= 16,
+
+	.init		= kuznechik_init,
+	.fini		= kuznechik_fini,
+	.clone		= kuznechik_clone,
+
+	.set		= set,
+
+	.encrypt	= encrypt,
+	.decrypt	= decrypt,
+
+	.encrypt_n	= encrypt_n_avx2,
+	.decrypt_n	= decrypt_n_avx2,
+};
+
+const struct crypto_core kuznechik_avx512_core = {
+	.size		= sizeof (struct state),
+	.block_size	= 16,
+
+	.init		= kuznechik_init,
+	.fini		= kuznechik_fini,
+	.clone		= kuznechik_clone,
 
-	.get		= get,
 	.set		= set,
 
 	.encrypt	= encrypt,
 	.decrypt	= decrypt,
+
+	.encrypt_n	= encrypt_n_avx512,
+	.decrypt_n	= decrypt_n_avx512,
 };
+
+const struct crypto_core kuznechik_enc_avx512_core = {
+	.size		= ENC_SIZE,
+	.block_size	= 16,
+
+	.init		= kuznechik_init,
+	.fini		= kuznechik_fini,
+	.clone		= kuznechik_clone,
+
+	.set		= set,
+
+	.encrypt	= encrypt,
+	.encrypt_n	= encrypt_n_avx512,
+};
+
+#endif  /* CRYPTO_CPU_X86 */
@@ -0,0 +1,179 @@
+/*
+ * Magma Cipher: AVX2 Engine
+ *
+ * Copyright (c) 2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * Standard: GOST 28147-89, GOST R 34.12-2015
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifdef __AVX2__
+
+#include <immintrin.h>
+
+#include "magma-simd.h"
+
+/*
+ * Halves of eight blocks are held in 32-bit lanes of a and b, two such sets
+ * are processed together to hide latency of round function.
+ */
+typedef __m256i V;
+
+#define GROUP		16
+
+#define XOR(a, b)	_mm256_xor_si256 (a, b)
+#define OR(a, b)	_mm256_or_si256 (a, b)
+#define AND(a, b)	_mm256_and_si256 (a, b)
+#define ADD(a, b)	_mm256_add_epi32 (a, b)
+#define SHUF(t, i)	_mm256_shuffle_epi8 (t, i)
+
+/*
+ * S-box of nibble i is looked up with pshufb in byte i / 2 only: index bit 7
+ * set in other bytes zeroes them.
+ */
+struct sbox {
+	V t[8];
+	V m[4];
+};
+
+static void sbox_load (struct sbox *o, const u8 s[8][16])
+{
+	int i;
+
+	for (i = 0; i < 8; ++i)
+		o->t[i] = _mm256_broadcastsi128_si256 (
+				_mm_loadu_si128 ((const void *) s[i]));
+
+	for (i = 0; i < 4; ++i)
+		o->m[i] = _mm256_set1_epi32 (0x80808080 & ~(0xffu << 8 * i));
+}
+
+static inline always_inline V f (const struct sbox *s, V x)
+{
+	const V m = _mm256_set1_epi8 (0x0f);
+	const V l = AND (x, m);
+	const V h = AND (_mm256_srli_epi16 (x, 4), m);
+	V y = _mm256_setzero_si256 ();
+	int i;
+
+#pragma GCC unroll 4
+	for (i = 0; i < 4; ++i) {
+		y = OR (y, SHUF (s->t[2 * i],     OR (l, s->m[i])));
+		y = OR (y, SHUF (s->t[2 * i + 1], OR (h, s->m[i])));
+	}
+
+	return OR (_mm256_slli_epi32 (y, 11), _mm256_srli_epi32 (y, 21));
+}
+
+static inline always_inline V bswap (V x)
+{
+	const V m = _mm256_setr_epi8 (3, 2, 1, 0, 7, 6, 5, 4,
+				      11, 10, 9, 8, 15, 14, 13, 12,
+				      3, 2, 1, 0, 7, 6, 5, 4,
+				      11, 10, 9, 8, 15, 14, 13, 12);
+	return SHUF (x, m);
+}
+
+/* split eight blocks into halves as encrypt in magma.c reads them */
+static inline always_inline void load (int le, const u8 *in, V *a, V *b)
+{
+	V x = _mm256_loadu_si256 ((const void *) in);
+	V y = _mm256_loadu_si256 ((const void *) (in + 32));
+	V e, o;
+
+	if (!le) {
+		x = bswap (x);
+		y = bswap (y);
+	}
+
+	e = _mm256_castps_si256 (_mm256_shuffle_ps (_mm256_castsi256_ps (x),
+						    _mm256_castsi256_ps (y),
+						    0x88));
+	o = _mm256_castps_si256 (_mm256_shuffle_ps (_mm256_castsi256_ps (x),
+						    _mm256_castsi256_ps (y),
+						    0xdd));
+	*a = le ? e : o;
+	*b = le ? o : e;
+}
+
+static inline always_inline void store (int le, V a, V b, u8 *out)
+{
+	V x = le ? _mm256_unpacklo_epi32 (b, a) : _mm256_unpacklo_epi32 (a, b);
+	V y = le ? _mm256_unpackhi_epi32 (b, a) : _mm256_unpackhi_epi32 (a, b);
+
+	if (!le) {
+		x = bswap (x);
+		y = bswap (y);
+	}
+
+	_mm256_storeu_si256 ((void *) out, x);
+	_mm256_storeu_si256 ((void *) (out + 32), y);
+}
+
+/* round key order */
+static const u8 order_enc[32] = {
+	0, 1, 2, 3, 4, 5, 6, 7,  0, 1, 2, 3, 4, 5, 6, 7,
+	0, 1, 2, 3, 4, 5, 6, 7,  7, 6, 5, 4, 3, 2, 1, 0,
+};
+
+static const u8 order_dec[32] = {
+	0, 1, 2, 3, 4, 5, 6, 7,  7, 6, 5, 4, 3, 2, 1, 0,
+	7, 6, 5, 4, 3, 2, 1, 0,  7, 6, 5, 4, 3, 2, 1, 0,
+};
+
+static inline always_inline
+void crypt_group (const u32 k[8], const struct sbox *s, const u8 *order,
+		  int le, const u8 *in, u8 *out)
+{
+	V a0, b0, a1, b1, ka, kb;
+	int r;
+
+	load (le, in,      &a0, &b0);
+	load (le, in + 64, &a1, &b1);
+
+	/* instead of swapping halves, swap names each round */
+	for (r = 0; r < 32; r += 2) {
+		ka = _mm256_set1_epi32 (k[order[r]]);
+		kb = _mm256_set1_epi32 (k[order[r + 1]]);
+
+		b0 = XOR (b0, f (s, ADD (a0, ka)));
+		b1 = XOR (b1, f (s, ADD (a1, ka)));
+		a0 = XOR (a0, f (s, ADD (b0, kb)));
+		a1 = XOR (a1, f (s, ADD (b1, kb)));
+	}
+
+	store (le, a0, b0, out);
+	store (le, a1, b1, out + 64);
+}
+
+static size_t crypt (const u32 k[8], const u8 s[8][16], const u8 *order,
+		     int le, const u8 *in, u8 *out, size_t count)
+{
+	const size_t n = count / GROUP * GROUP;
+	struct sbox sb;
+
+	sbox_load (&sb, s);
+
+	for (count = n; count > 0; count -= GROUP, in += GROUP * 8,
+					       out += GROUP * 8)
+		if (le)
+			crypt_group (k, &sb, order, 1, in, out);
+		else
+			crypt_group (k, &sb, order, 0, in, out);
+
+	return n;
+}
+
+size_t magma_encrypt_avx2 (const u32 k[8], const u8 s[8][16], int le,
+			   const void *in, void *out, size_t count)
+{
+	return crypt (k, s, order_enc, le, in, out, count);
+}
+
+size_t magma_decrypt_avx2 (const u32 k[8], const u8 s[8][16], int le,
+			   const void *in, void *out, size_t count)
+{
+	return crypt (k, s, order_dec, le, in, out, count);
+}
+
+#endif  /* __AVX2__ */
@@ -0,0 +1,187 @@
+/*
+ * Magma Cipher: Bitsliced Engine
+ *
+ * Copyright (c) 2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * Standard: GOST 28147-89, GOST R 34.12-2015
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <string.h>
+
+#include <crypto/endian.h>
+#include <crypto/utils.h>
+
+#include "magma-simd.h"
+
+/*
+ * A group of 64 blocks is transposed so that plane x[i] holds bit i of
+ * every block of the group: bits 0 .. 31 of x[i] belong to half a, bits
+ * 32 .. 63 to half b. Rotation of round function is a plane renaming, no
+ * memory access and no branch depends on key or data.
+ */
+#define GROUP  64
+
+/* 64 x 64 bit transposition is its own inverse */
+static void transpose (u64 x[64])
+{
+	u64 m, t;
+	int j, k;
+
+	for (j = 32, m = 0x00000000ffffffffULL; j != 0; j >>= 1, m ^= m << j)
+		for (k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+			t = ((x[k] >> j) ^ x[k | j]) & m;
+			x[k]     ^= t << j;
+			x[k | j] ^= t;
+		}
+}
+
+/* y = x + k mod 2^32, ripple carry with key bit masks */
+static inline always_inline void add_key (const u64 x[32], u32 k, u64 y[32])
+{
+	u64 c = 0, m, t;
+	int i;
+
+#pragma GCC unroll 32
+	for (i = 0; i < 32; ++i) {
+		m = -(u64) (k >> i & 1);
+		t = x[i] ^ m;
+		y[i] = t ^ c;
+		c = (x[i] & m) | (t & c);
+	}
+}
+
+/* s ? b : a */
+static inline always_inline u64 mux (u64 s, u64 a, u64 b)
+{
+	return a ^ ((a ^ b) & s);
+}
+
+/*
+ * All sixteen functions of x[0] and x[1] are computed once, output bit q
+ * selects four of them by circuit c[q] from paramset and muxes by x[2] and
+ * x[3].
+ */
+static inline always_inline
+void sbox (const u8 c[4][4], const u64 x[4], u64 y[4])
+{
+	const u64 n0 = ~x[0], n1 = ~x[1];
+	u64 g[16];
+	int t, q;
+
+	g[0] = 0;
+	g[1] = n0   & n1;
+	g[2] = x[0] & n1;
+	g[4] = n0   & x[1];
+	g[8] = x[0] & x[1];
+
+#pragma GCC unroll 16
+	for (t = 3; t < 16; ++t)
+		if ((t & (t - 1)) != 0)
+			g[t] = g[t & (t - 1)] | g[t & -t];
+
+#pragma GCC unroll 4
+	for (q = 0; q < 4; ++q)
+		y[q] = mux (x[3], mux (x[2], g[c[q][0]], g[c[q][1]]),
+				  mux (x[2], g[c[q][2]], g[c[q][3]]));
+}
+
+/* b ^= f (a + k) */
+static inline always_inline
+void feistel (const u8 c[8][4][4], u32 k, const u64 a[32], u64 b[32])
+{
+	u64 s[32], y[4];
+	int i, q;
+
+	add_key (a, k, s);
+
+	for (i = 0; i < 8; ++i) {
+		sbox (c[i], s + 4 * i, y);
+
+#pragma GCC unroll 4
+		for (q = 0; q < 4; ++q)
+			b[(4 * i + q + 11) & 31] ^= y[q];
+	}
+}
+
+/* round key order */
+static const u8 order_enc[32] = {
+	0, 1, 2, 3, 4, 5, 6, 7,  0, 1, 2, 3, 4, 5, 6, 7,
+	0, 1, 2, 3, 4, 5, 6, 7,  7, 6, 5, 4, 3, 2, 1, 0,
+};
+
+static const u8 order_dec[32] = {
+	0, 1, 2, 3, 4, 5, 6, 7,  7, 6, 5, 4, 3, 2, 1, 0,
+	7, 6, 5, 4, 3, 2, 1, 0,  7, 6, 5, 4, 3, 2, 1, 0,
+};
+
+static void crypt_group (const u32 k[8], const u8 c[8][4][4],
+			 const u8 *order, int le, const u8 *in, u8 *out)
+{
+	u64 x[64];
+	u32 a, b;
+	int j, r;
+
+	for (j = 0; j < 64; ++j, in += 8) {
+		if (le) {
+			a = read_le32 (in);
+			b = read_le32 (in + 4);
+		}
+		else {
+			a = read_be32 (in + 4);
+			b = read_be32 (in);
+		}
+
+		x[j] = (u64) b << 32 | a;
+	}
+
+	transpose (x);
+
+	/* instead of swapping halves, swap names each round */
+	for (r = 0; r < 32; r += 2) {
+		feistel (c, k[order[r]],     x,      x + 32);
+		feistel (c, k[order[r + 1]], x + 32, x);
+	}
+
+	transpose (x);
+
+	for (j = 0; j < 64; ++j, out += 8) {
+		a = x[j];
+		b = x[j] >> 32;
+
+		if (le) {
+			write_le32 (a, out + 4);
+			write_le32 (b, out);
+		}
+		else {
+			write_be32 (a, out);
+			write_be32 (b, out + 4);
+		}
+	}
+
+	memset_secure (x, 0, sizeof (x));
+}
+
+static size_t crypt (const u32 k[8], const u8 c[8][4][4], const u8 *order,
+		     int le, const u8 *in, u8 *out, size_t count)
+{
+	const size_t n = count / GROUP * GROUP;
+
+	for (count = n; count > 0; count -= GROUP, in += GROUP * 8,
+					       out += GROUP * 8)
+		crypt_group (k, c, order, le, in, out);
+
+	return n;
+}
+
+size_t magma_encrypt_bs (const u32 k[8], const u8 c[8][4][4], int le,
+			 const void *in, void *out, size_t count)
+{
+	return crypt (k, c, order_enc, le, in, out, count);
+}
+
+size_t magma_decrypt_bs (const u32 k[8], const u8 c[8][4][4], int le,
+			 const void *in, void *out, size_t count)
+{
+	return crypt (k, c, order_dec, le, in, out, count);
+}
@@ -0,0 +1,37 @@
+/*
+ * Magma Cipher: Vector Engines
+ *
+ * Copyright (c) 2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * Standard: GOST 28147-89, GOST R 34.12-2015
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef CRYPTO_MAGMA_SIMD_H
+#define CRYPTO_MAGMA_SIMD_H  1
+
+#include <stddef.h>
+
+#include <crypto/types.h>
+
+/*
+ * Process whole groups of 16 blocks with round keys k and nibble S-boxes s,
+ * where s[i][x] = pi[i][x] << 4 for odd i, le selects GOST 28147-89 byte
+ * order. Returns number of blocks processed.
+ */
+size_t magma_encrypt_avx2 (const u32 k[8], const u8 s[8][16], int le,
+			   const void *in, void *out, size_t count);
+size_t magma_decrypt_avx2 (const u32 k[8], const u8 s[8][16], int le,
+			   const void *in, void *out, size_t count);
+
+/*
+ * Bitsliced engine: process whole groups of 64 blocks, c[i][q] selects
+ * functions of low two input bits of S-box i for output bit q, see
+ * tables_build in magma.c.
+ */
+size_t magma_encrypt_bs (const u32 k[8], const u8 c[8][4][4], int le,
+			 const void *in, void *out, size_t count);
+size_t magma_decrypt_bs (const u32 k[8], const u8 c[8][4][4], int le,
+			 const void *in, void *out, size_t count);
+
+#endif  /* CRYPTO_MAGMA_SIMD_H */
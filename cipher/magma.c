@@ -8,6 +8,7 @@
  */
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -17,41 +18,167 @@
 #include <cipher/magma.h>
 #include <cipher/magma-sb.h>
 
-struct state {
-	struct crypto crypto;
-	const struct gost89_sb *sb;
-	u32 k[8];
+#include "magma-simd.h"
+
+/*
+ * S-box tables depend on paramset only: one read-only set per paramset is
+ * shared by all states. Sets are found by S-box contents, sets of named
+ * paramsets are pinned, sets of raw ones are released with last user.
+ *
+ * Merged 16-bit tables k8765 and k4321 (512 KiB) halve the number of
+ * lookups per round, they are built on first use by wide backend. Nibble
+ * S-boxes are used by vector engines, circuits by bitsliced engine.
+ */
+struct tables {
+	struct tables *next;
+	struct gost89_sb sb;
+	unsigned refs;
+	int pinned;
 	u32 k87[256], k65[256], k43[256], k21[256];
+	u32 (*wide)[65536];	/* k8765, k4321 or NULL */
+	u8 nib[8][16];		/* pi[i] << 4 for odd i */
+	u8 circ[8][4][4];	/* bitsliced S-box circuits */
 };
 
-static int magma_reset (struct state *o)
-{
-	memset_secure (o->k, 0, sizeof (o->k));
+static pthread_mutex_t tables_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct tables *tables_list;
 
-	memset_secure (o->k87, 0, sizeof (o->k87));
-	memset_secure (o->k65, 0, sizeof (o->k65));
-	memset_secure (o->k43, 0, sizeof (o->k43));
-	memset_secure (o->k21, 0, sizeof (o->k21));
-	return 0;
-}
+/* tables of all-zero S-box for state without key, never widened */
+static struct tables tables_none;
 
-static void table_init (struct state *o, int le)
+static void tables_build (struct tables *t)
 {
-	const struct gost89_sb *b = o->sb;
-	int i, h, l;
-
-	if (b == NULL)
-		b = le ? &gost89_sb_cpro_a : &magma_sb;
+	const struct gost89_sb *b = &t->sb;
+	int i, h, l, q, v;
 
 	for (i = 0; i < 256; ++i) {
 		h = i / 16;
 		l = i % 16;
 
-		o->k87[i] = rol32 ((b->pi[7][h] << 4 | b->pi[6][l]) << 24, 11);
-		o->k65[i] = rol32 ((b->pi[5][h] << 4 | b->pi[4][l]) << 16, 11);
-		o->k43[i] = rol32 ((b->pi[3][h] << 4 | b->pi[2][l]) << 8,  11);
-		o->k21[i] = rol32 ((b->pi[1][h] << 4 | b->pi[0][l]),       11);
+		t->k87[i] = rol32 ((b->pi[7][h] << 4 | b->pi[6][l]) << 24, 11);
+		t->k65[i] = rol32 ((b->pi[5][h] << 4 | b->pi[4][l]) << 16, 11);
+		t->k43[i] = rol32 ((b->pi[3][h] << 4 | b->pi[2][l]) << 8,  11);
+		t->k21[i] = rol32 ((b->pi[1][h] << 4 | b->pi[0][l]),       11);
+	}
+
+	for (i = 0; i < 8; ++i)
+		for (l = 0; l < 16; ++l)
+			t->nib[i][l] = b->pi[i][l] << 4 * (i & 1);
+
+	/*
+	 * Output bit q of S-box i for inputs 4h + l: bit l of circ[i][q][h]
+	 * is a truth table of function of two low input bits.
+	 */
+	for (i = 0; i < 8; ++i)
+		for (q = 0; q < 4; ++q)
+			for (h = 0; h < 4; ++h) {
+				for (v = 0, l = 0; l < 4; ++l)
+					v |= (b->pi[i][4 * h + l] >> q & 1) << l;
+
+				t->circ[i][q][h] = v;
+			}
+}
+
+static int tables_widen (struct tables *t)
+{
+	u32 (*w)[65536];
+	int ok = 1;
+	size_t i;
+
+	pthread_mutex_lock (&tables_lock);
+
+	if (t->wide == NULL) {
+		if ((w = malloc (2 * sizeof (w[0]))) != NULL) {
+			for (i = 0; i < 65536; ++i) {
+				w[0][i] = t->k87[i >> 8] | t->k65[i & 255];
+				w[1][i] = t->k43[i >> 8] | t->k21[i & 255];
+			}
+
+			t->wide = w;
+		}
+		else
+			ok = 0;
+	}
+
+	pthread_mutex_unlock (&tables_lock);
+	return ok;
+}
+
+static struct tables *tables_get (const struct gost89_sb *sb, int pin)
+{
+	struct tables *t;
+
+	pthread_mutex_lock (&tables_lock);
+
+	for (t = tables_list; t != NULL; t = t->next)
+		if (memcmp (&t->sb, sb, sizeof (*sb)) == 0)
+			break;
+
+	if (t == NULL && (t = malloc (sizeof (*t))) != NULL) {
+		t->sb     = *sb;
+		t->refs   = 0;
+		t->pinned = 0;
+		t->wide   = NULL;
+		tables_build (t);
+
+		t->next = tables_list;
+		tables_list = t;
+	}
+
+	if (t != NULL) {
+		t->pinned |= pin;
+		++t->refs;
+	}
+
+	pthread_mutex_unlock (&tables_lock);
+	return t;
+}
+
+static void tables_ref (struct tables *t)
+{
+	if (t == &tables_none)
+		return;
+
+	pthread_mutex_lock (&tables_lock);
+	++t->refs;
+	pthread_mutex_unlock (&tables_lock);
+}
+
+static void tables_put (struct tables *t)
+{
+	struct tables **p;
+
+	if (t == &tables_none)
+		return;
+
+	pthread_mutex_lock (&tables_lock);
+
+	if (--t->refs == 0 && !t->pinned) {
+		for (p = &tables_list; *p != t; p = &(*p)->next) {}
+
+		*p = t->next;
+		free (t->wide);
+		free (t);
 	}
+
+	pthread_mutex_unlock (&tables_lock);
+}
+
+struct state {
+	struct crypto crypto;
+	const struct gost89_sb *sb;
+	struct tables *t;
+	int wide;
+	u32 k[8];
+};
+
+static int magma_reset (struct state *o)
+{
+	memset_secure (o->k, 0, sizeof (o->k));
+
+	tables_put (o->t);
+	o->t = &tables_none;
+	return 0;
 }
 
 struct sb_map {
@@ -96,42 +223,76 @@ static int set_sb (struct state *o, int le, va_list ap)
 	return 0;
 }
 
+/* tables of named paramsets are kept for later users */
+static int sb_is_named (const struct gost89_sb *sb)
+{
+	const struct sb_map *p;
+
+	for (p = sb_map; p->name != NULL; ++p)
+		if (p->sb == sb)
+			return 1;
+
+	return sb == NULL;
+}
+
 static int set_key (struct state *o, int le, va_list ap)
 {
 	const void *key = va_arg (ap, const void *);
 	size_t len = va_arg (ap, size_t);
+	const struct gost89_sb *b = o->sb;
+	struct tables *t;
 	size_t i;
 
 	if (len != 32)
 		return -EINVAL;
 
-	for (i = 0; i < 8; ++i, key += 4)
-		o->k[i] = (le ? read_le32 : read_be32) (key);
+	if (b == NULL)
+		b = le ? &gost89_sb_cpro_a : &magma_sb;
+
+	/* raw paramset could be changed since last key set */
+	if (memcmp (&o->t->sb, b, sizeof (*b)) != 0) {
+		if ((t = tables_get (b, sb_is_named (o->sb))) == NULL)
+			return -ENOMEM;
+
+		tables_put (o->t);
+		o->t = t;
+	}
+
+	if (o->wide && !tables_widen (o->t))
+		return -ENOMEM;
+
+	for (i = 0; i < 8; ++i)
+		o->k[i] = (le ? read_le32 : read_be32) (key + 4 * i);
 
-	table_init (o, le);
 	return 0;
 }
 
-static u32 f (struct state *o, u32 x)
+static inline always_inline u32 f (struct state *o, int wide, u32 x)
 {
-	return o->k87[x >> 24 & 255] | o->k65[x >> 16 & 255] |
-	       o->k43[x >>  8 & 255] | o->k21[x       & 255];
+	const struct tables *t = o->t;
+
+	if (wide)
+		return t->wide[0][x >> 16] | t->wide[1][x & 0xffff];
+
+	return t->k87[x >> 24 & 255] | t->k65[x >> 16 & 255] |
+	       t->k43[x >>  8 & 255] | t->k21[x       & 255];
 }
 
 /* Instead of swapping halves, swap names each round */
 #define direct_rounds(o, a, b) \
-	b ^= f (o, a + o->k[0]); a ^= f (o, b + o->k[1]); \
-	b ^= f (o, a + o->k[2]); a ^= f (o, b + o->k[3]); \
-	b ^= f (o, a + o->k[4]); a ^= f (o, b + o->k[5]); \
-	b ^= f (o, a + o->k[6]); a ^= f (o, b + o->k[7]);
+	b ^= f (o, wide, a + o->k[0]); a ^= f (o, wide, b + o->k[1]); \
+	b ^= f (o, wide, a + o->k[2]); a ^= f (o, wide, b + o->k[3]); \
+	b ^= f (o, wide, a + o->k[4]); a ^= f (o, wide, b + o->k[5]); \
+	b ^= f (o, wide, a + o->k[6]); a ^= f (o, wide, b + o->k[7]);
 
 #define reverse_rounds(o, a, b) \
-	b ^= f (o, a + o->k[7]); a ^= f (o, b + o->k[6]); \
-	b ^= f (o, a + o->k[5]); a ^= f (o, b + o->k[4]); \
-	b ^= f (o, a + o->k[3]); a ^= f (o, b + o->k[2]); \
-	b ^= f (o, a + o->k[1]); a ^= f (o, b + o->k[0]);
+	b ^= f (o, wide, a + o->k[7]); a ^= f (o, wide, b + o->k[6]); \
+	b ^= f (o, wide, a + o->k[5]); a ^= f (o, wide, b + o->k[4]); \
+	b ^= f (o, wide, a + o->k[3]); a ^= f (o, wide, b + o->k[2]); \
+	b ^= f (o, wide, a + o->k[1]); a ^= f (o, wide, b + o->k[0]);
 
-static void encrypt (void *state, int le, const void *in, void *out)
+static inline always_inline
+void encrypt (void *state, int le, int wide, const void *in, void *out)
 {
 	struct state *o = state;
 	u32 a, b;
@@ -160,7 +321,8 @@ static void encrypt (void *state, int le, const void *in, void *out)
 	}
 }
 
-static void decrypt (void *state, int le, const void *in, void *out)
+static inline always_inline
+void decrypt (void *state, int le, int wide, const void *in, void *out)
 {
 	struct state *o = state;
 	u32 a, b;
@@ -191,42 +353,294 @@ static void decrypt (void *state, int le, const void *in, void *out)
 
 static void encrypt_le (void *state, const void *in, void *out)
 {
-	encrypt (state, 1, in, out);
+	encrypt (state, 1, 0, in, out);
 }
 
 static void decrypt_le (void *state, const void *in, void *out)
 {
-	decrypt (state, 1, in, out);
+	decrypt (state, 1, 0, in, out);
 }
 
 static void encrypt_be (void *state, const void *in, void *out)
 {
-	encrypt (state, 0, in, out);
+	encrypt (state, 0, 0, in, out);
 }
 
 static void decrypt_be (void *state, const void *in, void *out)
 {
-	decrypt (state, 0, in, out);
+	decrypt (state, 0, 0, in, out);
 }
 
-static void *alloc (void)
+static void encrypt_n_le (void *state, const void *src, void *dst, size_t count)
 {
-	return calloc (1, sizeof (struct state));
+	const u8 *in = src;
+	u8 *out = dst;
+
+	for (; count > 0; --count, in += 8, out += 8)
+		encrypt (state, 1, 0, in, out);
 }
 
-static void magma_free (void *state)
+static void decrypt_n_le (void *state, const void *src, void *dst, size_t count)
 {
-	magma_reset (state);
-	free (state);
+	const u8 *in = src;
+	u8 *out = dst;
+
+	for (; count > 0; --count, in += 8, out += 8)
+		decrypt (state, 1, 0, in, out);
 }
 
-static int get (const void *state, int type, va_list ap)
+static void encrypt_n_be (void *state, const void *src, void *dst, size_t count)
 {
-	switch (type) {
-	case CRYPTO_BLOCK_SIZE: return 8;
+	const u8 *in = src;
+	u8 *out = dst;
+
+	for (; count > 0; --count, in += 8, out += 8)
+		encrypt (state, 0, 0, in, out);
+}
+
+static void decrypt_n_be (void *state, const void *src, void *dst, size_t count)
+{
+	const u8 *in = src;
+	u8 *out = dst;
+
+	for (; count > 0; --count, in += 8, out += 8)
+		decrypt (state, 0, 0, in, out);
+}
+
+/* state without key has no wide tables, it takes the 4-table path */
+static int has_wide (const struct state *o)
+{
+	return o->t->wide != NULL;
+}
+
+static void encrypt_le_wide (void *state, const void *in, void *out)
+{
+	if (!has_wide (state)) {
+		encrypt_le (state, in, out);
+		return;
 	}
 
-	return -ENOSYS;
+	encrypt (state, 1, 1, in, out);
+}
+
+static void decrypt_le_wide (void *state, const void *in, void *out)
+{
+	if (!has_wide (state)) {
+		decrypt_le (state, in, out);
+		return;
+	}
+
+	decrypt (state, 1, 1, in, out);
+}
+
+static void encrypt_be_wide (void *state, const void *in, void *out)
+{
+	if (!has_wide (state)) {
+		encrypt_be (state, in, out);
+		return;
+	}
+
+	encrypt (state, 0, 1, in, out);
+}
+
+static void decrypt_be_wide (void *state, const void *in, void *out)
+{
+	if (!has_wide (state)) {
+		decrypt_be (state, in, out);
+		return;
+	}
+
+	decrypt (state, 0, 1, in, out);
+}
+
+static void encrypt_n_le_wide (void *state, const void *src, void *dst,
+				size_t count)
+{
+	const u8 *in = src;
+	u8 *out = dst;
+
+	if (!has_wide (state)) {
+		encrypt_n_le (state, in, out, count);
+		return;
+	}
+
+	for (; count > 0; --count, in += 8, out += 8)
+		encrypt (state, 1, 1, in, out);
+}
+
+static void decrypt_n_le_wide (void *state, const void *src, void *dst,
+				size_t count)
+{
+	const u8 *in = src;
+	u8 *out = dst;
+
+	if (!has_wide (state)) {
+		decrypt_n_le (state, in, out, count);
+		return;
+	}
+
+	for (; count > 0; --count, in += 8, out += 8)
+		decrypt (state, 1, 1, in, out);
+}
+
+static void encrypt_n_be_wide (void *state, const void *src, void *dst,
+				size_t count)
+{
+	const u8 *in = src;
+	u8 *out = dst;
+
+	if (!has_wide (state)) {
+		encrypt_n_be (state, in, out, count);
+		return;
+	}
+
+	for (; count > 0; --count, in += 8, out += 8)
+		encrypt (state, 0, 1, in, out);
+}
+
+static void decrypt_n_be_wide (void *state, const void *src, void *dst,
+				size_t count)
+{
+	const u8 *in = src;
+	u8 *out = dst;
+
+	if (!has_wide (state)) {
+		decrypt_n_be (state, in, out, count);
+		return;
+	}
+
+	for (; count > 0; --count, in += 8, out += 8)
+		decrypt (state, 0, 1, in, out);
+}
+
+/* whole groups of 64 blocks go to bitsliced engine, the rest to table path */
+static void encrypt_n_le_bs (void *state, const void *src, void *dst,
+			     size_t count)
+{
+	struct state *o = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t n = magma_encrypt_bs (o->k, o->t->circ, 1, in, out, count);
+
+	encrypt_n_le (o, in + n * 8, out + n * 8, count - n);
+}
+
+static void encrypt_n_be_bs (void *state, const void *src, void *dst,
+			     size_t count)
+{
+	struct state *o = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t n = magma_encrypt_bs (o->k, o->t->circ, 0, in, out, count);
+
+	encrypt_n_be (o, in + n * 8, out + n * 8, count - n);
+}
+
+static void decrypt_n_le_bs (void *state, const void *src, void *dst,
+			     size_t count)
+{
+	struct state *o = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t n = magma_decrypt_bs (o->k, o->t->circ, 1, in, out, count);
+
+	decrypt_n_le (o, in + n * 8, out + n * 8, count - n);
+}
+
+static void decrypt_n_be_bs (void *state, const void *src, void *dst,
+			     size_t count)
+{
+	struct state *o = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t n = magma_decrypt_bs (o->k, o->t->circ, 0, in, out, count);
+
+	decrypt_n_be (o, in + n * 8, out + n * 8, count - n);
+}
+
+#ifdef CRYPTO_CPU_X86
+
+/* whole groups of blocks go to vector engine, the rest to table path */
+static void encrypt_n_le_avx2 (void *state, const void *src, void *dst,
+			       size_t count)
+{
+	struct state *o = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t n = magma_encrypt_avx2 (o->k, o->t->nib, 1, in, out,
+					     count);
+
+	encrypt_n_le (o, in + n * 8, out + n * 8, count - n);
+}
+
+static void decrypt_n_le_avx2 (void *state, const void *src, void *dst,
+			       size_t count)
+{
+	struct state *o = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t n = magma_decrypt_avx2 (o->k, o->t->nib, 1, in, out,
+					     count);
+
+	decrypt_n_le (o, in + n * 8, out + n * 8, count - n);
+}
+
+static void encrypt_n_be_avx2 (void *state, const void *src, void *dst,
+			       size_t count)
+{
+	struct state *o = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t n = magma_encrypt_avx2 (o->k, o->t->nib, 0, in, out,
+					     count);
+
+	encrypt_n_be (o, in + n * 8, out + n * 8, count - n);
+}
+
+static void decrypt_n_be_avx2 (void *state, const void *src, void *dst,
+			       size_t count)
+{
+	struct state *o = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t n = magma_decrypt_avx2 (o->k, o->t->nib, 0, in, out,
+					     count);
+
+	decrypt_n_be (o, in + n * 8, out + n * 8, count - n);
+}
+
+#endif  /* CRYPTO_CPU_X86 */
+
+static void magma_init (void *state)
+{
+	struct state *o = state;
+
+	o->sb   = NULL;
+	o->t    = &tables_none;
+	o->wide = 0;
+	magma_reset (o);
+}
+
+static void magma_wide_init (void *state)
+{
+	struct state *o = state;
+
+	magma_init (o);
+	o->wide = 1;
+}
+
+static void magma_fini (void *state)
+{
+	magma_reset (state);
+}
+
+static int magma_clone (void *state, const void *from)
+{
+	struct state *o = state;
+
+	memcpy (o, from, sizeof (*o));
+	tables_ref (o->t);
+	return 0;
 }
 
 static int set (void *state, int le, int type, va_list ap)
@@ -251,23 +665,141 @@ static int set_be (void *state, int type, va_list ap)
 }
 
 const struct crypto_core gost89_core = {
-	.alloc		= alloc,
-	.free		= magma_free,
+	.size		= sizeof (struct state),
+	.block_size	= 8,
+
+	.init		= magma_init,
+	.fini		= magma_fini,
+	.clone		= magma_clone,
 
-	.get		= get,
 	.set 		= set_le,
 
 	.encrypt	= encrypt_le,
 	.decrypt	= decrypt_le,
+
+	.encrypt_n	= encrypt_n_le,
+	.decrypt_n	= decrypt_n_le,
 };
 
 const struct crypto_core magma_core = {
-	.alloc		= alloc,
-	.free		= free,
+	.size		= sizeof (struct state),
+	.block_size	= 8,
+
+	.init		= magma_init,
+	.fini		= magma_fini,
+	.clone		= magma_clone,
 
-	.get		= get,
 	.set 		= set_be,
 
 	.encrypt	= encrypt_be,
 	.decrypt	= decrypt_be,
+
+	.encrypt_n	= encrypt_n_be,
+	.decrypt_n	= decrypt_n_be,
+};
+
+const struct crypto_core gost89_wide_core = {
+	.size		= sizeof (struct state),
+	.block_size	= 8,
+
+	.init		= magma_wide_init,
+	.fini		= magma_fini,
+	.clone		= magma_clone,
+
+	.set 		= set_le,
+
+	.encrypt	= encrypt_le_wide,
+	.decrypt	= decrypt_le_wide,
+
+	.encrypt_n	= encrypt_n_le_wide,
+	.decrypt_n	= decrypt_n_le_wide,
+};
+
+const struct crypto_core magma_wide_core = {
+	.size		= sizeof (struct state),
+	.block_size	= 8,
+
+	.init		= magma_wide_init,
+	.fini		= magma_fini,
+	.clone		= magma_clone,
+
+	.set 		= set_be,
+
+	.encrypt	= encrypt_be_wide,
+	.decrypt	= decrypt_be_wide,
+
+	.encrypt_n	= encrypt_n_be_wide,
+	.decrypt_n	= decrypt_n_be_wide,
 };
+
+const struct crypto_core gost89_bs_core = {
+	.size		= sizeof (struct state),
+	.block_size	= 8,
+
+	.init		= magma_init,
+	.fini		= magma_fini,
+	.clone		= magma_clone,
+
+	.set 		= set_le,
+
+	.encrypt	= encrypt_le,
+	.decrypt	= decrypt_le,
+
+	.encrypt_n	= encrypt_n_le_bs,
+	.decrypt_n	= decrypt_n_le_bs,
+};
+
+const struct crypto_core magma_bs_core = {
+	.size		= sizeof (struct state),
+	.block_size	= 8,
+
+	.init		= magma_init,
+	.fini		= magma_fini,
+	.clone		= magma_clone,
+
+	.set 		= set_be,
+
+	.encrypt	= encrypt_be,
+	.decrypt	= decrypt_be,
+
+	.encrypt_n	= encrypt_n_be_bs,
+	.decrypt_n	= decrypt_n_be_bs,
+};
+
+#ifdef CRYPTO_CPU_X86
+
+const struct crypto_core gost89_avx2_core = {
+	.size		= sizeof (struct state),
+	.block_size	= 8,
+
+	.init		= magma_init,
+	.fini		= magma_fini,
+	.clone		= magma_clone,
+
+	.set 		= set_le,
+
+	.encrypt	= encrypt_le,
+	.decrypt	= decrypt_le,
+
+	.encrypt_n	= encrypt_n_le_avx2,
+	.decrypt_n	= decrypt_n_le_avx2,
+};
+
+const struct crypto_core magma_avx2_core = {
+	.size		= sizeof (struct state),
+	.block_size	= 8,
+
+	.init		= magma_init,
+	.fini		= magma_fini,
+	.clone		= magma_clone,
+
+	.set 		= set_be,
+
+	.encrypt	= encrypt_be,
+	.decrypt	= decrypt_be,
+
+	.encrypt_n	= encrypt_n_be_avx2,
+	.decrypt_n	= decrypt_n_be_avx2,
+};
+
+#endif  /* CRYPTO_CPU_X86 */
@@ -0,0 +1,63 @@
+/*
+ * Crypto API CPU Features
+ *
+ * Copyright (c) 2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <pthread.h>
+
+#include <crypto/cpu.h>
+
+#ifdef CRYPTO_CPU_X86
+
+static unsigned detect (void)
+{
+	unsigned features = 0;
+
+	__builtin_cpu_init ();
+
+	if (__builtin_cpu_supports ("sse2"))
+		features |= CRYPTO_CPU_SSE2;
+
+	if (__builtin_cpu_supports ("ssse3"))
+		features |= CRYPTO_CPU_SSSE3;
+
+	if (__builtin_cpu_supports ("avx2"))
+		features |= CRYPTO_CPU_AVX2;
+
+	if (__builtin_cpu_supports ("avx512f") &&
+	    __builtin_cpu_supports ("avx512bw") &&
+	    __builtin_cpu_supports ("avx512vbmi"))
+		features |= CRYPTO_CPU_AVX512;
+
+	if (__builtin_cpu_supports ("gfni"))
+		features |= CRYPTO_CPU_GFNI;
+
+	return features;
+}
+
+#else
+
+static unsigned detect (void)
+{
+	return 0;
+}
+
+#endif
+
+static unsigned features;
+
+static void init (void)
+{
+	features = detect ();
+}
+
+unsigned crypto_cpu_features (void)
+{
+	static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+	pthread_once (&once, init);
+	return features;
+}
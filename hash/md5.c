@@ -8,7 +8,6 @@
  */
 
 #include <errno.h>
-#include <stdlib.h>
 #include <string.h>
 
 #include <crypto/types.h>
@@ -111,6 +110,7 @@ static const u32 T[64] = {
 
 struct state {
 	struct crypto crypto;
+	u8 block[MD5_BLOCK_SIZE];  /* partial block of high-level API */
 	u32 hash[MD5_ORDER];
 	u64 count;
 };
@@ -138,25 +138,23 @@ static int md5_reset (struct state *o)
 	return 0;
 }
 
-static void *md5_core_alloc (void)
+static void md5_core_init (void *state)
 {
-	struct state *o;
-
-	if ((o = malloc (sizeof (*o))) == NULL)
-		return NULL;
+	struct state *o = state;
 
+	o->crypto.block = o->block;
 	md5_reset (o);
-	return o;
 }
 
-static int md5_core_get (const void *state, int type, va_list ap)
+static void md5_core_fini (void *state)
 {
-	switch (type) {
-	case CRYPTO_BLOCK_SIZE:		return MD5_BLOCK_SIZE;
-	case CRYPTO_OUTPUT_SIZE:	return MD5_HASH_SIZE;
-	}
+	md5_reset (state);
+}
 
-	return -ENOSYS;
+static int md5_core_clone (void *state, const void *from)
+{
+	memcpy (state, from, sizeof (struct state));
+	return 0;
 }
 
 static int md5_core_set (void *state, int type, va_list ap)
@@ -254,10 +252,14 @@ static void md5_core_final (void *state, const void *in, size_t len, void *out)
 }
 
 const struct crypto_core md5_core = {
-	.alloc		= md5_core_alloc,
-	.free		= free,
+	.size		= sizeof (struct state),
+	.block_size	= MD5_BLOCK_SIZE,
+	.output_size	= MD5_HASH_SIZE,
+
+	.init		= md5_core_init,
+	.fini		= md5_core_fini,
+	.clone		= md5_core_clone,
 
-	.get		= md5_core_get,
 	.set		= md5_core_set,
 
 	.transform	= md5_core_transform,
@@ -8,7 +8,6 @@
  */
 
 #include <errno.h>
-#include <stdlib.h>
 #include <string.h>
 
 #include <crypto/types.h>
@@ -82,6 +81,7 @@ static void mix_word (u32 *W, int i)
 
 struct state {
 	struct crypto crypto;
+	u8 block[SHA1_BLOCK_SIZE];  /* partial block of high-level API */
 	u32 hash[SHA1_ORDER];
 	u64 count;
 };
@@ -108,25 +108,23 @@ static int sha1_reset (struct state *o)
 	return 0;
 }
 
-static void *sha1_core_alloc (void)
+static void sha1_core_init (void *state)
 {
-	struct state *o;
-
-	if ((o = malloc (sizeof (*o))) == NULL)
-		return NULL;
+	struct state *o = state;
 
+	o->crypto.block = o->block;
 	sha1_reset (o);
-	return o;
 }
 
-static int sha1_core_get (const void *state, int type, va_list ap)
+static void sha1_core_fini (void *state)
 {
-	switch (type) {
-	case CRYPTO_BLOCK_SIZE:		return SHA1_BLOCK_SIZE;
-	case CRYPTO_OUTPUT_SIZE:	return SHA1_HASH_SIZE;
-	}
+	sha1_reset (state);
+}
 
-	return -ENOSYS;
+static int sha1_core_clone (void *state, const void *from)
+{
+	memcpy (state, from, sizeof (struct state));
+	return 0;
 }
 
 static int sha1_core_set (void *state, int type, va_list ap)
@@ -227,10 +225,14 @@ static void sha1_core_final (void *state, const void *in, size_t len,
 }
 
 const struct crypto_core sha1_core = {
-	.alloc		= sha1_core_alloc,
-	.free		= free,
+	.size		= sizeof (struct state),
+	.block_size	= SHA1_BLOCK_SIZE,
+	.output_size	= SHA1_HASH_SIZE,
+
+	.init		= sha1_core_init,
+	.fini		= sha1_core_fini,
+	.clone		= sha1_core_clone,
 
-	.get		= sha1_core_get,
 	.set		= sha1_core_set,
 
 	.transform	= sha1_core_transform,
@@ -134,4 +134,21 @@ static const u512 C_table[12] = {
 	}}},
 };
 
+static inline u8 pi (u8 a)
+{
+	return pi_table[a];
+}
+
+static inline u64 l (u64 b)
+{
+	u64 mask, c;
+	int i;
+
+	for (i = 0, mask = (1ULL << 63), c = 0; i < 64; mask >>= 1, ++i)
+		if ((b & mask) != 0)
+			c ^= A_table[i];
+
+	return c;
+}
+
 #endif  /* CRYPTO_STRIBOG_DEFS_H */
@@ -0,0 +1,98 @@
+/*
+ * Stribog Hash Algorithm: Table Generator
+ *
+ * Copyright (c) 2013-2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * Standard: GOST R 34.11-2012
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "stribog-defs.h"
+
+static void LPS (const u512 *a, u512 *result)
+{
+	u64 x;
+	int i, j;
+
+	for (i = 0; i < 8; ++i) {
+		for (j = 0, x = 0; j < 8; ++j)
+			x |= (u64) pi (a->m[j][i]) << (j * 8);
+
+		result->q[i] = l (x);
+	}
+}
+
+static void show (const char *indent, const u512 *a)
+{
+	int i;
+
+	printf ("%s{{{\n", indent);
+
+	for (i = 0; i < 8; i += 2)
+		printf ("%s\t0x%016" PRIx64 ", 0x%016" PRIx64 ",\n", indent,
+			a->q[i], a->q[i + 1]);
+
+	printf ("%s}}},\n", indent);
+}
+
+/* key schedule of E for K = LPS (N ^ h) with N = 0 */
+static void show_iv (const char *name, const u512 *iv)
+{
+	u512 K, x;
+	int i, j;
+
+	printf ("\t{\t/* %s */\n", name);
+	show ("\t\t", iv);
+	printf ("\t\t{\n");
+
+	LPS (iv, &K);
+	show ("\t\t\t", &K);
+
+	for (i = 0; i < 12; ++i) {
+		for (j = 0; j < 8; ++j)
+			x.q[j] = K.q[j] ^ C_table[i].q[j];
+
+		LPS (&x, &K);
+		show ("\t\t\t", &K);
+	}
+
+	printf ("\t\t},\n\t},\n");
+}
+
+int main (void)
+{
+	static const u512 iv_512, iv_256 = {{{
+		0x0101010101010101, 0x0101010101010101,
+		0x0101010101010101, 0x0101010101010101,
+		0x0101010101010101, 0x0101010101010101,
+		0x0101010101010101, 0x0101010101010101,
+	}}};
+	int i, j;
+
+	printf ("/* generated by stribog-gen, do not edit */\n\n"
+		"#include \"stribog-tables.h\"\n\n"
+		"const u64 stribog_LPS[8][256] = {\n");
+
+	for (j = 0; j < 8; ++j) {
+		printf ("\t{\n");
+
+		for (i = 0; i < 256; ++i)
+			printf ("%s0x%016" PRIx64 ",%s", i % 4 == 0 ? "\t\t" : " ",
+				l (((u64) pi (i)) << (j * 8)),
+				i % 4 == 3 ? "\n" : "");
+
+		printf ("\t},\n");
+	}
+
+	printf ("};\n\n"
+		"const struct stribog_iv stribog_iv[2] = {\n");
+
+	show_iv ("stribog-512", &iv_512);
+	show_iv ("stribog-256", &iv_256);
+
+	printf ("};\n");
+	return 0;
+}
@@ -0,0 +1,21 @@
+/*
+ * Stribog Hash Algorithm: Vector Engines
+ *
+ * Copyright (c) 2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * Standard: GOST R 34.11-2012
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef CRYPTO_STRIBOG_SIMD_H
+#define CRYPTO_STRIBOG_SIMD_H  1
+
+#include "stribog-defs.h"
+
+/* compression function g(N, h, m) with state kept in SSE registers */
+void stribog_g_sse2 (const u512 *N, const u512 *h, const u512 *m,
+		     u512 *result);
+void stribog_gk_sse2 (const u512 K[13], const u512 *h, const u512 *m,
+		      u512 *result);
+
+#endif  /* CRYPTO_STRIBOG_SIMD_H */
@@ -0,0 +1,160 @@
+/*
+ * Stribog Hash Algorithm: SSE2 Engine
+ *
+ * Copyright (c) 2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * Standard: GOST R 34.11-2012
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifdef __SSE2__
+
+/*
+ * The whole compression function is inlined into stribog_g_sse2: 512-bit
+ * state lives in four SSE registers between LPS steps.
+ *
+ * LPS output word i is a sum of table lookups indexed by byte i of every
+ * input word: 8 x 8 byte matrix of state is transposed in registers, then
+ * indices are extracted from rows without memory round trip.
+ */
+
+#include <emmintrin.h>
+
+#include "stribog-simd.h"
+#include "stribog-tables.h"
+
+typedef struct {
+	__m128i x[4];
+} S;
+
+static inline always_inline S load (const u512 *a)
+{
+	S s;
+	int i;
+
+	for (i = 0; i < 4; ++i)
+		s.x[i] = _mm_loadu_si128 ((const void *) (a->q + 2 * i));
+
+	return s;
+}
+
+static inline always_inline void store (S s, u512 *a)
+{
+	int i;
+
+	for (i = 0; i < 4; ++i)
+		_mm_storeu_si128 ((void *) (a->q + 2 * i), s.x[i]);
+}
+
+static inline always_inline S xor512 (S a, S b)
+{
+	int i;
+
+	for (i = 0; i < 4; ++i)
+		a.x[i] = _mm_xor_si128 (a.x[i], b.x[i]);
+
+	return a;
+}
+
+/* row x.x[i / 2] holds words 2i and 2i + 1, returns columns in the same way */
+static inline always_inline S transpose (S a)
+{
+	__m128i s[4], u[4];
+	int i;
+
+	/* bytes of words 2i and 2i + 1 interleaved */
+	for (i = 0; i < 4; ++i)
+		s[i] = _mm_unpacklo_epi8 (a.x[i], _mm_srli_si128 (a.x[i], 8));
+
+	u[0] = _mm_unpacklo_epi16 (s[0], s[1]);
+	u[1] = _mm_unpackhi_epi16 (s[0], s[1]);
+	u[2] = _mm_unpacklo_epi16 (s[2], s[3]);
+	u[3] = _mm_unpackhi_epi16 (s[2], s[3]);
+
+	a.x[0] = _mm_unpacklo_epi32 (u[0], u[2]);
+	a.x[1] = _mm_unpackhi_epi32 (u[0], u[2]);
+	a.x[2] = _mm_unpacklo_epi32 (u[1], u[3]);
+	a.x[3] = _mm_unpackhi_epi32 (u[1], u[3]);
+	return a;
+}
+
+/*
+ * Words of LPS output from two transposed rows in x: pextrw fetches two
+ * indices at once, that unloads integer ports, lookups and sums stay there.
+ */
+#define IDX(x, k)	((unsigned) _mm_extract_epi16 (x, k))
+#define LPS2(j, e)	(stribog_LPS[j][(e) & 255] ^ stribog_LPS[j + 1][(e) >> 8])
+
+static inline always_inline __m128i lps_pair (__m128i x)
+{
+	const unsigned e0 = IDX (x, 0), e1 = IDX (x, 1), e2 = IDX (x, 2),
+		       e3 = IDX (x, 3), e4 = IDX (x, 4), e5 = IDX (x, 5),
+		       e6 = IDX (x, 6), e7 = IDX (x, 7);
+
+	return _mm_set_epi64x (LPS2 (0, e4) ^ LPS2 (2, e5) ^
+			       LPS2 (4, e6) ^ LPS2 (6, e7),
+			       LPS2 (0, e0) ^ LPS2 (2, e1) ^
+			       LPS2 (4, e2) ^ LPS2 (6, e3));
+}
+
+#undef LPS2
+#undef IDX
+
+static inline always_inline S LPS (S a)
+{
+	int i;
+
+	a = transpose (a);
+
+#pragma GCC unroll 4
+	for (i = 0; i < 4; ++i)
+		a.x[i] = lps_pair (a.x[i]);
+
+	return a;
+}
+
+static inline always_inline S LPSX (S a, S b)
+{
+	return LPS (xor512 (a, b));
+}
+
+static inline always_inline S E (S K, S m)
+{
+	S r;
+	int i;
+
+	r = LPSX (K, m);
+
+	for (i = 0; i < 11; ++i) {
+		K = LPSX (K, load (C_table + i));
+		r = LPSX (K, r);
+	}
+
+	K = LPSX (K, load (C_table + 11));
+	return xor512 (K, r);
+}
+
+/* g(N, h, m) = E(LPS(N ^ h), m) ^ h ^ m */
+void stribog_g_sse2 (const u512 *N, const u512 *h, const u512 *m,
+		     u512 *result)
+{
+	const S H = load (h), M = load (m);
+
+	store (xor512 (xor512 (E (LPSX (load (N), H), M), H), M), result);
+}
+
+/* g(0, IV, m) with keys of E precomputed */
+void stribog_gk_sse2 (const u512 K[13], const u512 *h, const u512 *m,
+		      u512 *result)
+{
+	const S H = load (h), M = load (m);
+	S r = LPSX (load (K), M);
+	int i;
+
+	for (i = 1; i < 12; ++i)
+		r = LPSX (load (K + i), r);
+
+	store (xor512 (xor512 (xor512 (load (K + 12), r), H), M), result);
+}
+
+#endif  /* __SSE2__ */
@@ -0,0 +1,29 @@
+/*
+ * Stribog Hash Algorithm: Precomputed Tables
+ *
+ * Copyright (c) 2013-2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * Standard: GOST R 34.11-2012
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef CRYPTO_STRIBOG_TABLES_H
+#define CRYPTO_STRIBOG_TABLES_H  1
+
+#include "stribog-defs.h"
+
+/* generated at build time by stribog-gen into stribog-tables.c */
+extern const u64 stribog_LPS[8][256];
+
+/*
+ * Initial hash value and keys of E for the first compression: N = 0 and
+ * h = IV there, thus keys do not depend on message.
+ */
+struct stribog_iv {
+	u512 h;
+	u512 K[13];
+};
+
+extern const struct stribog_iv stribog_iv[2];  /* stribog-512, stribog-256 */
+
+#endif  /* CRYPTO_STRIBOG_TABLES_H */
@@ -0,0 +1,516 @@
+/*
+ * Stribog Tree Hash Mode
+ *
+ * Copyright (c) 2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <crypto/api.h>
+#include <crypto/endian.h>
+#include <crypto/utils.h>
+
+#include <hash/stribog-tree.h>
+
+#define BS	64	/* block size of stribog */
+#define HS	64	/* output size of stribog-512 */
+#define CHUNK	STRIBOG_TREE_CHUNK
+
+/* chunks hashed in parallel at once */
+#define BATCH	64
+
+enum domain {
+	TREE_LEAF,
+	TREE_NODE,
+	TREE_ROOT,
+};
+
+struct key {
+	u8 block[BS];
+	size_t len;  /* zero for unkeyed mode */
+};
+
+/* complete subtrees of decreasing size, see tree_push */
+struct tree {
+	u8 stack[64][HS];
+	size_t depth;
+	u64 count;  /* leaves pushed */
+};
+
+static int key_init (struct key *k, const void *key, size_t len)
+{
+	if (len > sizeof (k->block) || (key == NULL && len > 0))
+		return 0;
+
+	memset (k->block, 0, sizeof (k->block));
+
+	if (len > 0)
+		memcpy (k->block, key, len);
+
+	k->len = len;
+	return 1;
+}
+
+/* H (K || B (domain, param) || data) */
+static void hash (struct crypto *h, const struct key *k, int domain, u64 param,
+		  const u8 *data, size_t len, u8 *out)
+{
+	u8 head[BS] = {};
+
+	head[0] = domain;
+	head[1] = k->len;
+	write_le64 (param, head + 8);
+
+	if (k->len > 0)
+		h->core->transform (h, k->block);
+
+	if (len == 0) {
+		h->core->final (h, head, BS, out);
+		return;
+	}
+
+	h->core->transform (h, head);
+
+	for (; len > BS; data += BS, len -= BS)
+		h->core->transform (h, data);
+
+	h->core->final (h, data, len, out);
+}
+
+/* replace two top subtrees with their parent, they are adjacent in stack */
+static void tree_node (struct crypto *h, const struct key *k, struct tree *t)
+{
+	u8 *left = t->stack[t->depth - 2];
+
+	hash (h, k, TREE_NODE, 0, left, 2 * HS, left);
+	--t->depth;
+}
+
+/* subtrees of equal size are merged as soon as the right one is complete */
+static void tree_push (struct crypto *h, const struct key *k, struct tree *t,
+		       const u8 *leaf)
+{
+	u64 n;
+
+	memcpy (t->stack[t->depth++], leaf, HS);
+
+	for (n = ++t->count; (n & 1) == 0; n >>= 1)
+		tree_node (h, k, t);
+}
+
+static void tree_root (struct crypto *h, const struct key *k, struct tree *t,
+		       u64 length, u8 *out)
+{
+	while (t->depth > 1)
+		tree_node (h, k, t);
+
+	hash (h, k, TREE_ROOT, length, t->stack[0], HS, out);
+}
+
+struct worker {
+	pthread_t thread;
+	struct state *o;
+	struct crypto *h;
+	unsigned gen;  /* last batch seen */
+};
+
+struct state {
+	struct crypto crypto;
+	struct key key;
+	struct tree tree;
+	u64 length;		/* message size so far */
+	u8 *chunk;		/* partial chunk, allocated on first use */
+	size_t avail;
+	struct crypto *h;	/* hash of caller thread */
+
+	/* worker pool, caller thread takes part in every batch */
+	struct worker *worker;
+	size_t workers;
+	pthread_mutex_t lock;
+	pthread_cond_t start, done;
+	unsigned gen, busy;
+	int quit;
+
+	/* current batch, leaf digests are pushed into tree in order */
+	const u8 *job[BATCH];
+	size_t jobs, next;
+	u8 leaf[BATCH][HS];
+};
+
+static void tree_work (struct state *o, struct crypto *h)
+{
+	size_t i;
+
+	while ((i = __atomic_fetch_add (&o->next, 1, __ATOMIC_RELAXED)) <
+	       o->jobs)
+		hash (h, &o->key, TREE_LEAF, o->tree.count + i, o->job[i],
+		      CHUNK, o->leaf[i]);
+}
+
+static void *worker (void *arg)
+{
+	struct worker *w = arg;
+	struct state *o = w->o;
+
+	pthread_mutex_lock (&o->lock);
+
+	for (;;) {
+		while (!o->quit && w->gen == o->gen)
+			pthread_cond_wait (&o->start, &o->lock);
+
+		if (o->quit)
+			break;
+
+		w->gen = o->gen;
+		pthread_mutex_unlock (&o->lock);
+
+		tree_work (o, w->h);
+
+		pthread_mutex_lock (&o->lock);
+
+		if (--o->busy == 0)
+			pthread_cond_signal (&o->done);
+	}
+
+	pthread_mutex_unlock (&o->lock);
+	return NULL;
+}
+
+static void pool_stop (struct state *o)
+{
+	size_t i;
+
+	pthread_mutex_lock (&o->lock);
+	o->quit = 1;
+	pthread_cond_broadcast (&o->start);
+	pthread_mutex_unlock (&o->lock);
+
+	for (i = 0; i < o->workers; ++i) {
+		pthread_join (o->worker[i].thread, NULL);
+		crypto_free (o->worker[i].h);
+	}
+
+	free (o->worker);
+	o->worker  = NULL;
+	o->workers = 0;
+	o->quit    = 0;
+}
+
+static int pool_start (struct state *o, size_t count)
+{
+	struct worker *w;
+	int ret;
+
+	if ((o->worker = calloc (count, sizeof (o->worker[0]))) == NULL)
+		return -errno;
+
+	for (; o->workers < count; ++o->workers) {
+		w = o->worker + o->workers;
+		w->o   = o;
+		w->gen = o->gen;
+
+		if ((w->h = crypto_alloc ("stribog")) == NULL) {
+			ret = -errno;
+			goto error;
+		}
+
+		if ((ret = -pthread_create (&w->thread, NULL, worker, w)) != 0) {
+			crypto_free (w->h);
+			goto error;
+		}
+	}
+
+	return 0;
+error:
+	pool_stop (o);
+	return ret;
+}
+
+static void tree_batch (struct state *o, size_t count)
+{
+	const int pool = o->workers > 0 && count > 1;
+	size_t i;
+
+	o->jobs = count;
+	o->next = 0;
+
+	if (pool) {
+		pthread_mutex_lock (&o->lock);
+		o->busy = o->workers;
+		++o->gen;
+		pthread_cond_broadcast (&o->start);
+		pthread_mutex_unlock (&o->lock);
+	}
+
+	tree_work (o, o->h);
+
+	if (pool) {
+		pthread_mutex_lock (&o->lock);
+
+		while (o->busy > 0)
+			pthread_cond_wait (&o->done, &o->lock);
+
+		pthread_mutex_unlock (&o->lock);
+	}
+
+	for (i = 0; i < count; ++i)
+		tree_push (o->h, &o->key, &o->tree, o->leaf[i]);
+}
+
+static int tree_reset (struct state *o)
+{
+	if (o->chunk != NULL)
+		memset_secure (o->chunk, 0, CHUNK);
+
+	memset_secure (&o->tree, 0, sizeof (o->tree));
+	o->length = 0;
+	o->avail  = 0;
+	return 0;
+}
+
+static int tree_prepare (struct state *o)
+{
+	if (o->h == NULL && (o->h = crypto_alloc ("stribog")) == NULL)
+		return -errno;
+
+	if (o->chunk == NULL && (o->chunk = malloc (CHUNK)) == NULL)
+		return -errno;
+
+	return 0;
+}
+
+static void tree_init (void *state)
+{
+	struct state *o = state;
+
+	key_init (&o->key, NULL, 0);
+	memset (&o->tree, 0, sizeof (o->tree));
+	o->length = 0;
+	o->chunk  = NULL;
+	o->avail  = 0;
+	o->h      = NULL;
+
+	o->worker  = NULL;
+	o->workers = 0;
+	o->gen     = 0;
+	o->busy    = 0;
+	o->quit    = 0;
+
+	pthread_mutex_init (&o->lock,  NULL);
+	pthread_cond_init  (&o->start, NULL);
+	pthread_cond_init  (&o->done,  NULL);
+}
+
+static void tree_fini (void *state)
+{
+	struct state *o = state;
+
+	pool_stop (o);
+	tree_reset (o);
+	free (o->chunk);
+	crypto_free (o->h);
+	memset_secure (&o->key, 0, sizeof (o->key));
+
+	pthread_cond_destroy  (&o->done);
+	pthread_cond_destroy  (&o->start);
+	pthread_mutex_destroy (&o->lock);
+}
+
+/* worker pool of the same size is started for the copy */
+static int tree_clone (void *state, const void *from)
+{
+	const struct state *o = from;
+	struct state *c = state;
+	int ret;
+
+	c->crypto = o->crypto;
+	tree_init (c);
+
+	c->key    = o->key;
+	c->tree   = o->tree;
+	c->length = o->length;
+
+	if (o->chunk != NULL) {
+		if ((c->chunk = malloc (CHUNK)) == NULL) {
+			ret = -errno;
+			goto error;
+		}
+
+		memcpy (c->chunk, o->chunk, o->avail);
+		c->avail = o->avail;
+	}
+
+	if (o->workers > 0 && (ret = pool_start (c, o->workers)) != 0)
+		goto error;
+
+	return 0;
+error:
+	tree_fini (c);
+	return ret;
+}
+
+static int set_key (struct state *o, va_list ap)
+{
+	const void *key = va_arg (ap, const void *);
+	size_t len = va_arg (ap, size_t);
+
+	if (!key_init (&o->key, key, len))
+		return -EINVAL;
+
+	return tree_reset (o);
+}
+
+/* caller thread is counted */
+static int set_threads (struct state *o, va_list ap)
+{
+	size_t count = va_arg (ap, size_t);
+
+	if (count == 0)
+		return -EINVAL;
+
+	pool_stop (o);
+	return count > 1 ? pool_start (o, count - 1) : 0;
+}
+
+static int tree_set (void *state, int type, va_list ap)
+{
+	switch (type) {
+	case CRYPTO_RESET:	return tree_reset  (state);
+	case CRYPTO_KEY:	return set_key     (state, ap);
+	case CRYPTO_THREADS:	return set_threads (state, ap);
+	}
+
+	return -ENOSYS;
+}
+
+/*
+ * Whole chunks are hashed straight from caller memory, only a partial chunk
+ * is copied. A leaf does not depend on whether its chunk is the last one,
+ * thus a complete chunk is hashed at once.
+ */
+static int tree_update (void *state, const void *in, size_t len)
+{
+	struct state *o = state;
+	const u8 *p = in;
+	size_t n, count;
+	int ret;
+
+	if ((ret = tree_prepare (o)) != 0)
+		return ret;
+
+	o->length += len;
+
+	while (len > 0) {
+		count = 0;
+
+		if (o->avail > 0 || len < CHUNK) {
+			n = CHUNK - o->avail < len ? CHUNK - o->avail : len;
+
+			memcpy (o->chunk + o->avail, p, n);
+			o->avail += n, p += n, len -= n;
+
+			if (o->avail < CHUNK)
+				break;
+
+			o->job[count++] = o->chunk;
+		}
+
+		for (; count < BATCH && len >= CHUNK; p += CHUNK, len -= CHUNK)
+			o->job[count++] = p;
+
+		tree_batch (o, count);
+		o->avail = 0;
+	}
+
+	return 0;
+}
+
+static int tree_fetch (void *state, void *out, size_t len)
+{
+	struct state *o = state;
+	u8 root[HS];
+	int ret;
+
+	if (len > sizeof (root))
+		return -EINVAL;
+
+	if ((ret = tree_prepare (o)) != 0)
+		return ret;
+
+	/* the last partial chunk or the only empty one */
+	if (o->avail > 0 || o->tree.count == 0) {
+		hash (o->h, &o->key, TREE_LEAF, o->tree.count, o->chunk,
+		      o->avail, o->leaf[0]);
+		tree_push (o->h, &o->key, &o->tree, o->leaf[0]);
+	}
+
+	tree_root (o->h, &o->key, &o->tree, o->length, root);
+	memcpy (out, root, len);
+	return tree_reset (o);
+}
+
+const struct crypto_core stribog_tree_core = {
+	.size		= sizeof (struct state),
+	.output_size	= HS,
+
+	.init		= tree_init,
+	.fini		= tree_fini,
+	.clone		= tree_clone,
+
+	.set		= tree_set,
+
+	.update		= tree_update,
+	.fetch		= tree_fetch,
+};
+
+int stribog_tree_leaf (const void *key, size_t klen, u64 index,
+		       const void *chunk, size_t len, void *out)
+{
+	struct crypto *h;
+	struct key k;
+
+	if (len > CHUNK || !key_init (&k, key, klen)) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	if ((h = crypto_alloc ("stribog")) == NULL)
+		return 0;
+
+	hash (h, &k, TREE_LEAF, index, chunk, len, out);
+	crypto_free (h);
+	memset_secure (&k, 0, sizeof (k));
+	return 1;
+}
+
+int stribog_tree_root (const void *key, size_t klen,
+		       const void *leaves, u64 length, void *out)
+{
+	const u64 count = length == 0 ? 1 : (length - 1) / CHUNK + 1;
+	const u8 *leaf = leaves;
+	struct crypto *h;
+	struct tree t = {};
+	struct key k;
+	u64 i;
+
+	if (!key_init (&k, key, klen)) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	if ((h = crypto_alloc ("stribog")) == NULL)
+		return 0;
+
+	for (i = 0; i < count; ++i, leaf += HS)
+		tree_push (h, &k, &t, leaf);
+
+	tree_root (h, &k, &t, length, out);
+	crypto_free (h);
+	memset_secure (&k, 0, sizeof (k));
+	return 1;
+}
@@ -8,7 +8,6 @@
  */
 
 #include <errno.h>
-#include <stdlib.h>
 #include <string.h>
 
 #include <crypto/endian.h>
@@ -17,6 +16,8 @@
 #include <hash/stribog.h>
 
 #include "stribog-defs.h"
+#include "stribog-simd.h"
+#include "stribog-tables.h"
 
 /* use pseudo words to optimize endian conversions */
 #define STRIBOG_WORD_SIZE	8
@@ -26,23 +27,6 @@
 #define STRIBOG_BLOCK_SIZE	(STRIBOG_WORD_SIZE * STRIBOG_WORD_COUNT)
 #define STRIBOG_HASH_SIZE	(STRIBOG_WORD_SIZE * STRIBOG_ORDER)
 
-static u8 pi (u8 a)
-{
-	return pi_table[a];
-}
-
-static u64 l (u64 b)
-{
-	u64 mask, c;
-	int i;
-
-	for (i = 0, mask = (1ULL << 63), c = 0; i < 64; mask >>= 1, ++i)
-		if ((b & mask) != 0)
-			c ^= A_table[i];
-
-	return c;
-}
-
 static void xor512 (const u512 *a, const u512 *b, u512 *result)
 {
 	int i;
@@ -59,24 +43,13 @@ static void xor512 (const u512 *a, const u512 *b, u512 *result)
 static void LPS (const u512 *a, u512 *result)
 #if 1
 {
-	static u64 table[8][256];  /* 16K lookup table */
-	static int deployed;
-
 	int i, j;
 
-	if (!deployed) {
-		for (j = 0; j < 8; ++j)
-			for (i = 0; i < 256; ++i)
-				table[j][i] = l (((u64) pi (i)) << (j * 8));
-
-		deployed = 1;
-	}
-
 	for (i = 0; i < 8; ++i) {
-		result->q[i] = table[0][a->m[0][i]];
+		result->q[i] = stribog_LPS[0][a->m[0][i]];
 
 		for (j = 1; j < 8; ++j)
-			result->q[i] ^= table[j][a->m[j][i]];
+			result->q[i] ^= stribog_LPS[j][a->m[j][i]];
 	}
 }
 #elif 1
@@ -148,6 +121,22 @@ static void g (const u512 *N, const u512 *h, const u512 *m, u512 *result)
 	xor512 (&A, m, result);
 }
 
+/* g(0, IV, m) with keys of E precomputed */
+static void gk (const u512 K[13], const u512 *h, const u512 *m, u512 *result)
+{
+	u512 A;
+	int i;
+
+	LPSX (K, m, &A);
+
+	for (i = 1; i < 12; ++i)
+		LPSX (K + i, &A, &A);
+
+	xor512 (K + 12, &A, &A);
+	xor512 (&A, h, &A);
+	xor512 (&A, m, result);
+}
+
 /* OOPS: LE-variant, use u256.b for independence */
 static void add512 (const u512 *a, const u512 *b, u512 *result)
 {
@@ -161,9 +150,18 @@ static void add512 (const u512 *a, const u512 *b, u512 *result)
 	}
 }
 
+typedef void g_fn  (const u512 *N, const u512 *h, const u512 *m, u512 *result);
+typedef void gk_fn (const u512 K[13], const u512 *h, const u512 *m,
+		    u512 *result);
+
 struct state {
 	struct crypto crypto;
+	u8 block[STRIBOG_BLOCK_SIZE];  /* partial block of high-level API */
 	u512 h, N, Sum;
+	const struct stribog_iv *iv;
+	const u512 *K;	/* keys of the next compression if known */
+	g_fn  *g;	/* compression function of backend */
+	gk_fn *gk;	/* the same with keys given */
 };
 
 static void load (const u512 *in, u512 *out);
@@ -177,38 +175,44 @@ static int set_iv (struct state *o, va_list ap)
 		return -EINVAL;
 
 	load (iv, &o->h);
+	o->K = NULL;
 	return 0;
 }
 
 static int stribog_reset (struct state *o)
 {
-	/* IV for stribog-512, fill with 0x01 x 64 for stribog-256 */
-	memset_secure (&o->h,   0, sizeof (o->h));
+	o->h = o->iv->h;
+	o->K = o->iv->K;
 
 	memset_secure (&o->N,   0, sizeof (o->N));
 	memset_secure (&o->Sum, 0, sizeof (o->Sum));
 	return 0;
 }
 
-static void *stribog_core_alloc (void)
+static void stribog_init (struct state *o, const struct stribog_iv *iv,
+			  g_fn *g, gk_fn *gk)
 {
-	struct state *o;
-
-	if ((o = malloc (sizeof (*o))) == NULL)
-		return NULL;
-
+	o->crypto.block = o->block;
+	o->iv = iv;
+	o->g  = g;
+	o->gk = gk;
 	stribog_reset (o);
-	return o;
 }
 
-static int stribog_core_get (const void *state, int type, va_list ap)
+static void stribog_core_init (void *state)
 {
-	switch (type) {
-	case CRYPTO_BLOCK_SIZE:		return STRIBOG_BLOCK_SIZE;
-	case CRYPTO_OUTPUT_SIZE:	return STRIBOG_HASH_SIZE;
-	}
+	stribog_init (state, stribog_iv, g, gk);
+}
 
-	return -ENOSYS;
+static void stribog_core_fini (void *state)
+{
+	stribog_reset (state);
+}
+
+static int stribog_core_clone (void *state, const void *from)
+{
+	memcpy (state, from, sizeof (struct state));
+	return 0;
 }
 
 static int stribog_core_set (void *state, int type, va_list ap)
@@ -236,7 +240,13 @@ static void transform (void *state, const void *block, const u512 *count)
 
 	load (block, &W);
 
-	g (&o->N, &o->h, &W, &o->h);
+	if (o->K != NULL) {
+		o->gk (o->K, &o->h, &W, &o->h);
+		o->K = NULL;
+	}
+	else
+		o->g (&o->N, &o->h, &W, &o->h);
+
 	add512 (&o->N, count, &o->N);  /* add data size in bits */
 	add512 (&o->Sum, &W, &o->Sum);
 }
@@ -258,16 +268,15 @@ static void stribog_core_result (void *state, void *out)
 		write_le64 (o->h.q[i], result + i);
 }
 
-static void stribog_core_final (void *state, const void *in, size_t len,
-				void *out)
+/* known keys mark the first block of message, see stribog_reset */
+static void final (struct state *o, const void *in, size_t len)
 {
 	static const u512 N0;
-	struct state *o = state;
 	u8 block[STRIBOG_BLOCK_SIZE];
-	u512 bits = {};
+	u512 bits = {}, W;
 
 	if (len == STRIBOG_BLOCK_SIZE) {
-		stribog_core_transform (state, in);
+		stribog_core_transform (o, in);
 		len = 0;
 	}
 
@@ -282,74 +291,362 @@ static void stribog_core_final (void *state, const void *in, size_t len,
 	memset (one + 1, 0, end - (one + 1));
 
 	bits.q[0] = len * 8;
-	transform (state, block, &bits);
 
-	g (&N0, &o->h, &o->N,   &o->h);
-	g (&N0, &o->h, &o->Sum, &o->h);
+	if (o->K != NULL) {
+		/* single block message: N = bits, Sum = m */
+		load ((const void *) block, &W);
+
+		o->gk (o->K, &o->h, &W,    &o->h);
+		o->g  (&N0,  &o->h, &bits, &o->h);
+		o->g  (&N0,  &o->h, &W,    &o->h);
+		return;
+	}
+
+	transform (o, block, &bits);
+
+	o->g (&N0, &o->h, &o->N,   &o->h);
+	o->g (&N0, &o->h, &o->Sum, &o->h);
+}
 
+static void stribog_core_final (void *state, const void *in, size_t len,
+				void *out)
+{
+	final (state, in, len);
 	stribog_core_result (state, out);
 	stribog_reset (state);
 }
 
-const struct crypto_core stribog_core = {
-	.alloc		= stribog_core_alloc,
-	.free		= free,
+/*
+ * Multi-buffer engine: independent messages advance in lanes in lockstep,
+ * thus table lookups of LPS of different lanes overlap instead of waiting
+ * for each other. A lane takes next message as soon as its one is done,
+ * lanes left without messages hash zero blocks and results are dropped.
+ */
+#ifndef STRIBOG_LANES
+#define STRIBOG_LANES	4
+#endif
 
-	.get		= stribog_core_get,
-	.set		= stribog_core_set,
+#define L  STRIBOG_LANES
 
-	.transform	= stribog_core_transform,
-	.final		= stribog_core_final,
+/*
+ * r[l] = LPS (a[l] ^ b[l * step]) for every lane l, index bytes are shifted
+ * out of registers column by column instead of reloaded from memory. More
+ * than four lanes spill accumulators.
+ */
+static void LPSX_x (const u512 *a, const u512 *b, int step, u512 *r)
+{
+	u64 x[L][8], y[L][8], w;
+	int l, i, j;
+
+	for (l = 0; l < L; ++l)
+		for (i = 0; i < 8; ++i) {
+			x[l][i] = a[l].q[i] ^ b[l * step].q[i];
+			y[l][i] = 0;
+		}
+
+	for (j = 0; j < 8; ++j)
+#pragma GCC unroll 8
+		for (l = 0; l < L; ++l) {
+			w = x[l][j];
+#pragma GCC unroll 8
+			for (i = 0; i < 8; ++i, w >>= 8)
+				y[l][i] ^= stribog_LPS[j][w & 0xff];
+		}
+
+	for (l = 0; l < L; ++l)
+		for (i = 0; i < 8; ++i)
+			r[l].q[i] = y[l][i];
+}
+
+static void E_x (u512 *K, const u512 *m, u512 *result)
+{
+	int i, l;
+
+	LPSX_x (K, m, 1, result);
+
+	for (i = 0; i < 11; ++i) {
+		LPSX_x (K, C_table + i, 0, K);
+		LPSX_x (K, result, 1, result);
+	}
+	LPSX_x (K, C_table + 11, 0, K);
+
+	for (l = 0; l < L; ++l)
+		xor512 (K + l, result + l, result + l);
+}
+
+static void g_x (const u512 *N, const u512 *h, const u512 *m, u512 *result)
+{
+	u512 A[L], B[L];
+	int l;
+
+	LPSX_x (N, h, 1, A);
+	E_x (A, m, B);
+
+	for (l = 0; l < L; ++l) {
+		xor512 (B + l, h + l, A + l);
+		xor512 (A + l, m + l, result + l);
+	}
+}
+
+enum lane_phase {
+	LANE_IDLE,
+	LANE_DATA,	/* g (N, h, m) over blocks, last one padded */
+	LANE_LENGTH,	/* g (0, h, N) */
+	LANE_SUM,	/* g (0, h, Sum) */
 };
 
-static void *stribog_256_core_alloc (void)
+struct lane {
+	enum lane_phase phase;
+	const u8 *data;
+	size_t len;
+	u8 *out;
+	u512 h, N, Sum;
+};
+
+/* feed lane with message i, IV is taken from initial state o */
+static void lane_start (struct lane *p, const struct state *o,
+			const struct iovec *in, u8 *out)
+{
+	p->phase = LANE_DATA;
+	p->data  = in->iov_base;
+	p->len   = in->iov_len;
+	p->out   = out;
+	p->h     = o->h;
+
+	memset (&p->N,   0, sizeof (p->N));
+	memset (&p->Sum, 0, sizeof (p->Sum));
+}
+
+/* last (possibly empty) block of message is padded as in final */
+static void lane_block (const struct lane *p, u512 *m)
 {
-	struct state *o;
+	u8 block[STRIBOG_BLOCK_SIZE];
+
+	if (p->len >= sizeof (block)) {
+		load ((const void *) p->data, m);
+		return;
+	}
 
-	if ((o = stribog_core_alloc ()) == NULL)
-		return NULL;
+	memcpy (block, p->data, p->len);
+	block[p->len] = 1;
+	memset (block + p->len + 1, 0, sizeof (block) - p->len - 1);
 
-	memset (&o->h, 1, sizeof (o->h));  /* reset IV */
-	return o;
+	load ((const void *) block, m);
+	memset_secure (block, 0, sizeof (block));
 }
 
-static int stribog_256_core_get (const void *state, int type, va_list ap)
+static void lane_step (struct lane *p, const u512 *m, const u512 *h,
+		       size_t offset, size_t hs)
 {
-	if (type == CRYPTO_OUTPUT_SIZE)
-		return 32;
+	static const u512 N512 = {{{ 512 }}};
+	u512 bits = {};
+	u8 hash[STRIBOG_HASH_SIZE];
+	size_t i;
 
-	return stribog_core_get (state, type, ap);
+	p->h = *h;
+
+	switch (p->phase) {
+	case LANE_IDLE:
+		break;
+	case LANE_DATA:
+		add512 (&p->Sum, m, &p->Sum);
+
+		if (p->len >= STRIBOG_BLOCK_SIZE) {
+			add512 (&p->N, &N512, &p->N);
+			p->data += STRIBOG_BLOCK_SIZE;
+			p->len  -= STRIBOG_BLOCK_SIZE;
+			break;
+		}
+
+		bits.q[0] = p->len * 8;
+		add512 (&p->N, &bits, &p->N);
+		p->phase = LANE_LENGTH;
+		break;
+	case LANE_LENGTH:
+		p->phase = LANE_SUM;
+		break;
+	case LANE_SUM:
+		for (i = 0; i < STRIBOG_ORDER; ++i)
+			write_le64 (h->q[i], hash + i * 8);
+
+		memcpy (p->out, hash + offset, hs);
+		memset_secure (hash, 0, sizeof (hash));
+		p->phase = LANE_IDLE;
+		break;
+	}
 }
 
-static int stribog_256_core_set (void *state, int type, va_list ap)
+static void digest_n (const struct state *o, const struct iovec *in,
+		      size_t count, u8 *out, size_t offset, size_t hs)
 {
-	struct state *o = state;
-	int ret = stribog_core_get (state, type, ap);
+	struct lane lane[L];
+	u512 N[L], h[L], m[L], r[L];
+	size_t next;
+	int l, busy;
+
+	for (l = 0; l < L; ++l)
+		lane[l].phase = LANE_IDLE;
+
+	for (next = 0;; ) {
+		for (l = 0, busy = 0; l < L; ++l) {
+			struct lane *p = lane + l;
+
+			if (p->phase == LANE_IDLE && next < count) {
+				lane_start (p, o, in + next, out + next * hs);
+				++next;
+			}
+
+			memset (N + l, 0, sizeof (N[l]));
+			h[l] = p->h;
+
+			switch (p->phase) {
+			case LANE_IDLE:
+				memset (h + l, 0, sizeof (h[l]));
+				memset (m + l, 0, sizeof (m[l]));
+				break;
+			case LANE_DATA:
+				N[l] = p->N;
+				lane_block (p, m + l);
+				break;
+			case LANE_LENGTH:
+				m[l] = p->N;
+				break;
+			case LANE_SUM:
+				m[l] = p->Sum;
+				break;
+			}
+
+			busy |= p->phase != LANE_IDLE;
+		}
+
+		if (!busy)
+			break;
+
+		g_x (N, h, m, r);
+
+		for (l = 0; l < L; ++l)
+			lane_step (lane + l, m + l, r + l, offset, hs);
+	}
 
-	if (type == CRYPTO_RESET)
-		memset (&o->h, 1, sizeof (o->h));  /* reset IV */
+	memset_secure (lane, 0, sizeof (lane));
+	memset_secure (h, 0, sizeof (h));
+	memset_secure (m, 0, sizeof (m));
+	memset_secure (r, 0, sizeof (r));
+}
+
+#undef L
+
+static void stribog_core_digest_n (void *state, const struct iovec *in,
+				   size_t count, void *out)
+{
+	digest_n (state, in, count, out, 0, STRIBOG_HASH_SIZE);
+}
+
+const struct crypto_core stribog_core = {
+	.size		= sizeof (struct state),
+	.block_size	= STRIBOG_BLOCK_SIZE,
+	.output_size	= STRIBOG_HASH_SIZE,
+
+	.init		= stribog_core_init,
+	.fini		= stribog_core_fini,
+	.clone		= stribog_core_clone,
+
+	.set		= stribog_core_set,
 
-	return ret;
+	.transform	= stribog_core_transform,
+	.final		= stribog_core_final,
+
+	.digest_n	= stribog_core_digest_n,
+};
+
+static void stribog_256_core_init (void *state)
+{
+	stribog_init (state, stribog_iv + 1, g, gk);
 }
 
+/* stribog-256 is the high half of the result */
 static void stribog_256_core_final (void *state, const void *in, size_t len,
 				    void *out)
 {
 	struct state *o = state;
-	u8 hash[64];
+	u64 *result = out;
+	size_t i;
 
-	stribog_core_final (state, in, len, hash);
-	memset (&o->h, 1, sizeof (o->h));  /* reset IV */
-	memcpy (out, hash + 32, 32);
+	final (o, in, len);
+
+	for (i = 0; i < STRIBOG_ORDER / 2; ++i)
+		write_le64 (o->h.q[STRIBOG_ORDER / 2 + i], result + i);
+
+	stribog_reset (o);
+}
+
+static void stribog_256_core_digest_n (void *state, const struct iovec *in,
+				       size_t count, void *out)
+{
+	digest_n (state, in, count, out, 32, 32);
 }
 
 const struct crypto_core stribog_256_core = {
-	.alloc		= stribog_256_core_alloc,
-	.free		= free,
+	.size		= sizeof (struct state),
+	.block_size	= STRIBOG_BLOCK_SIZE,
+	.output_size	= 32,
+
+	.init		= stribog_256_core_init,
+	.fini		= stribog_core_fini,
+	.clone		= stribog_core_clone,
 
-	.get		= stribog_256_core_get,
-	.set		= stribog_256_core_set,
+	.set		= stribog_core_set,
 
 	.transform	= stribog_core_transform,
 	.final		= stribog_256_core_final,
+
+	.digest_n	= stribog_256_core_digest_n,
 };
+
+#ifdef CRYPTO_CPU_X86
+
+static void stribog_sse2_core_init (void *state)
+{
+	stribog_init (state, stribog_iv, stribog_g_sse2, stribog_gk_sse2);
+}
+
+static void stribog_256_sse2_core_init (void *state)
+{
+	stribog_init (state, stribog_iv + 1, stribog_g_sse2, stribog_gk_sse2);
+}
+
+const struct crypto_core stribog_sse2_core = {
+	.size		= sizeof (struct state),
+	.block_size	= STRIBOG_BLOCK_SIZE,
+	.output_size	= STRIBOG_HASH_SIZE,
+
+	.init		= stribog_sse2_core_init,
+	.fini		= stribog_core_fini,
+	.clone		= stribog_core_clone,
+
+	.set		= stribog_core_set,
+
+	.transform	= stribog_core_transform,
+	.final		= stribog_core_final,
+
+	.digest_n	= stribog_core_digest_n,
+};
+
+const struct crypto_core stribog_256_sse2_core = {
+	.size		= sizeof (struct state),
+	.block_size	= STRIBOG_BLOCK_SIZE,
+	.output_size	= 32,
+
+	.init		= stribog_256_sse2_core_init,
+	.fini		= stribog_core_fini,
+	.clone		= stribog_core_clone,
+
+	.set		= stribog_core_set,
+
+	.transform	= stribog_core_transform,
+	.final		= stribog_256_core_final,
+
+	.digest_n	= stribog_256_core_digest_n,
+};
+
+#endif  /* CRYPTO_CPU_X86 */
@@ -13,5 +13,22 @@
 #include <crypto/core.h>
 
 extern const struct crypto_core kuznechik_core;
+extern const struct crypto_core kuznechik_enc_core;  /* encrypt only */
+extern const struct crypto_core kuznechik_ref_core;  /* no tables */
+
+/* 8 KiB tables per direction for cache-constrained hosts */
+extern const struct crypto_core kuznechik_compact_core;
+extern const struct crypto_core kuznechik_enc_compact_core;
+
+#include <crypto/cpu.h>
+
+#ifdef CRYPTO_CPU_X86
+extern const struct crypto_core kuznechik_ssse3_core;
+extern const struct crypto_core kuznechik_avx2_core;
+
+/* AVX-512 and GFNI engine for bulk calls, table path for small ones */
+extern const struct crypto_core kuznechik_avx512_core;
+extern const struct crypto_core kuznechik_enc_avx512_core;
+#endif
 
 #endif  /* CRYPTO_KUZNECHIK_CORE_H */
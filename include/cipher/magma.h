@@ -15,4 +15,20 @@
 extern const struct crypto_core gost89_core;
 extern const struct crypto_core magma_core;
 
+/* merged 16-bit S-box tables: two lookups per round, 512 KiB per paramset */
+extern const struct crypto_core gost89_wide_core;
+extern const struct crypto_core magma_wide_core;
+
+/* constant-time bitsliced engine for multi-block calls */
+extern const struct crypto_core gost89_bs_core;
+extern const struct crypto_core magma_bs_core;
+
+#include <crypto/cpu.h>
+
+#ifdef CRYPTO_CPU_X86
+/* AVX2 engine for multi-block calls, table path for single blocks */
+extern const struct crypto_core gost89_avx2_core;
+extern const struct crypto_core magma_avx2_core;
+#endif
+
 #endif  /* CRYPTO_MAGMA_CORE_H */
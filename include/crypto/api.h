@@ -12,8 +12,47 @@
 #include <stdarg.h>
 #include <stddef.h>
 
+#include <sys/uio.h>
+
+/*
+ * Algorithm is given by name or by specification of composite algorithm,
+ * where inner algorithm follows in parentheses: "hmac(stribog-256)",
+ * "ctr(kuznechik)", "pbkdf2(hmac(stribog))".
+ */
 struct crypto *crypto_alloc (const char *algo);
 void crypto_free (struct crypto *o);
+struct crypto *crypto_clone (const struct crypto *o);
+
+/*
+ * Force backend (implementation) of algorithm, NULL backend restores choice
+ * of the best one supported by CPU. Initial choice is taken from environment
+ * variable CRYPTO_BACKEND = algo:backend[,algo:backend...]. Affects objects
+ * created after the call. Returns non-zero on success, zero otherwise.
+ */
+int crypto_set_backend (const char *algo, const char *backend);
+
+/*
+ * Parsed and resolved specification, could be used to construct objects
+ * repeatedly without parsing and registry lookup.
+ */
+struct crypto_spec *crypto_spec_parse (const char *spec);
+void crypto_spec_free (struct crypto_spec *o);
+
+struct crypto *crypto_spec_alloc (const struct crypto_spec *o);
+size_t crypto_spec_size (const struct crypto_spec *o);
+struct crypto *crypto_spec_init (void *buf, const struct crypto_spec *o);
+
+/*
+ * Construct object in caller memory of crypto_state_size (algo) bytes
+ * aligned to CRYPTO_STATE_ALIGN: on stack, in an arena or in a slab. Size
+ * of specification covers every object of the chain, when chain is built
+ * with crypto_set_algo reserve room for every object separately. The
+ * object is released with crypto_free, memory is left to the caller.
+ */
+#define CRYPTO_STATE_ALIGN  16
+
+size_t crypto_state_size (const char *algo);
+struct crypto *crypto_init (void *buf, const char *algo);
 
 int crypto_getv (const struct crypto *o, int type, va_list ap);
 int crypto_setv (struct crypto *o, int type, va_list ap);
@@ -31,13 +70,57 @@ int crypto_set_key	(struct crypto *o, const void *key,  size_t len);
 int crypto_set_iv	(struct crypto *o, const void *iv,   size_t len);
 int crypto_set_salt	(struct crypto *o, const void *salt, size_t len);
 int crypto_set_count	(struct crypto *o, size_t count);
+int crypto_set_threads	(struct crypto *o, size_t count);
 
 /* process one block of data */
 int crypto_encrypt (struct crypto *o, const void *in, void *out);
 int crypto_decrypt (struct crypto *o, const void *in, void *out);
 
+/* process count blocks of data */
+int crypto_encrypt_blocks (struct crypto *o, const void *in, void *out,
+			   size_t count);
+int crypto_decrypt_blocks (struct crypto *o, const void *in, void *out,
+			   size_t count);
+
 /* update object with data, and fetch result */
 int crypto_update (struct crypto *o, const void *in, size_t len);
 int crypto_fetch  (struct crypto *o, void *out, size_t len);
 
+/*
+ * Update object with data gathered from count fragments. Ciphers and block
+ * cipher modes encrypt fragments in place instead, total length must be a
+ * multiple of block size then.
+ */
+int crypto_updatev (struct crypto *o, const struct iovec *iov, size_t count);
+
+/*
+ * One-shot processing with all state on stack. Composite algorithms are
+ * given by outer (mac or mode) and inner (hash or cipher) names, mode could
+ * be NULL to use raw block cipher, iv could be NULL to use default one.
+ * Digest and MAC return output size on success, zero overwise, out must be
+ * able to hold full output.
+ */
+size_t crypto_digest (const char *algo, const void *in, size_t len, void *out);
+/*
+ * Digest count independent messages, digests are stored one after another
+ * into out. Hashes with multi-buffer engine process several messages at
+ * once, others one by one. Returns output size on success, zero otherwise.
+ */
+size_t crypto_digest_many (const char *algo, const struct iovec *in,
+			   size_t count, void *out);
+
+size_t crypto_mac (const char *mac, const char *algo,
+		   const void *key, size_t klen,
+		   const void *in, size_t len, void *out);
+
+/* returns non-zero on success, zero overwise */
+int crypto_encrypt_once (const char *mode, const char *algo,
+			 const void *key, size_t klen,
+			 const void *iv, size_t ivlen,
+			 const void *in, void *out, size_t count);
+int crypto_decrypt_once (const char *mode, const char *algo,
+			 const void *key, size_t klen,
+			 const void *iv, size_t ivlen,
+			 const void *in, void *out, size_t count);
+
 #endif  /* CRYPTO_API_H */
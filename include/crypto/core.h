@@ -12,6 +12,8 @@
 #include <stddef.h>
 #include <stdarg.h>
 
+#include <sys/uio.h>
+
 enum crypto_type {
 	CRYPTO_RESET,
 	CRYPTO_BLOCK_SIZE,
@@ -22,11 +24,20 @@ enum crypto_type {
 	CRYPTO_IV,
 	CRYPTO_SALT,
 	CRYPTO_COUNT,		/* round count */
+	CRYPTO_THREADS,		/* worker thread count */
 };
 
 struct crypto_core {
-	void *(*alloc) (void);
-	void (*free) (void *state);
+	size_t size;  /* size of state */
+
+	/* static sizes, zero if depends on parameters (use get then) */
+	size_t block_size;
+	size_t output_size;
+
+	/* construct empty state in place, wipe it and release nested objects */
+	void (*init) (void *state);
+	void (*fini) (void *state);
+	int (*clone) (void *state, const void *from);  /* deep copy */
 
 	int (*get) (const void *state, int type, va_list ap);
 	int (*set) (void *state, int type, va_list ap);
@@ -35,6 +46,10 @@ struct crypto_core {
 	void (*encrypt) (void *state, const void *in, void *out);
 	void (*decrypt) (void *state, const void *in, void *out);
 
+	/* encrypt/decrypt count blocks of data, optional */
+	void (*encrypt_n) (void *state, const void *in, void *out, size_t count);
+	void (*decrypt_n) (void *state, const void *in, void *out, size_t count);
+
 	/* transform one block of data, and finalize processing */
 	void (*transform) (void *state, const void *block);
 	void (*final) (void *state, const void *in, size_t len, void *out);
@@ -42,12 +57,26 @@ struct crypto_core {
 	/* update object with data, and fetch result */
 	int (*update) (void *state, const void *in, size_t len);
 	int (*fetch)  (void *state, void *out, size_t len);
+
+	/*
+	 * digest count independent messages starting from initial state,
+	 * digests are placed one after another, optional
+	 */
+	void (*digest_n) (void *state, const struct iovec *in, size_t count,
+			  void *out);
+};
+
+enum crypto_flags {
+	CRYPTO_HEAP	= 1,	/* state allocated by crypto_alloc */
 };
 
 struct crypto {
 	const struct crypto_core *core;
 	void *block;
 	size_t avail;
+	size_t block_size;	/* cached sizes, zero if not known */
+	size_t output_size;
+	int flags;
 	/* core-specific state follows */
 };
 
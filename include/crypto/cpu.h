@@ -0,0 +1,27 @@
+/*
+ * Crypto API CPU Features
+ *
+ * Copyright (c) 2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef CRYPTO_CPU_H
+#define CRYPTO_CPU_H  1
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define CRYPTO_CPU_X86  1
+#endif
+
+enum crypto_cpu_feature {
+	CRYPTO_CPU_SSE2		= 1 << 0,
+	CRYPTO_CPU_SSSE3	= 1 << 1,
+	CRYPTO_CPU_AVX2		= 1 << 2,
+	CRYPTO_CPU_AVX512	= 1 << 3,	/* F, BW and VBMI */
+	CRYPTO_CPU_GFNI		= 1 << 4,
+};
+
+/* returns set of features of current CPU, detected once */
+unsigned crypto_cpu_features (void);
+
+#endif  /* CRYPTO_CPU_H */
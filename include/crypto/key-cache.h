@@ -0,0 +1,42 @@
+/*
+ * Crypto API Key Schedule Cache
+ *
+ * Copyright (c) 2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef CRYPTO_KEY_CACHE_H
+#define CRYPTO_KEY_CACHE_H  1
+
+#include <stddef.h>
+
+/*
+ * Opt-in bounded LRU cache of expanded key schedules shared by all threads.
+ * Setup with zero entries disables the cache and wipes all entries, setup
+ * resets statistics. Returns non-zero on success, otherwise sets errno and
+ * returns zero.
+ */
+int crypto_key_cache_setup (size_t entries);
+
+struct crypto_key_cache_stats {
+	unsigned long hits, misses, evictions;
+	size_t entries, limit;
+};
+
+void crypto_key_cache_get_stats (struct crypto_key_cache_stats *o);
+
+/*
+ * Cipher interface: schedule is identified by kind (an address private to
+ * the cipher), parameter (an address of parameter set or NULL) and key.
+ * Lookup copies cached schedule of given size into sched and returns
+ * non-zero on hit, store saves freshly expanded schedule.
+ */
+int  crypto_key_cache_lookup (const void *kind, const void *param,
+			      const void *key, size_t len,
+			      void *sched, size_t size);
+void crypto_key_cache_store  (const void *kind, const void *param,
+			      const void *key, size_t len,
+			      const void *sched, size_t size);
+
+#endif  /* CRYPTO_KEY_CACHE_H */
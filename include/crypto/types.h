@@ -17,9 +17,11 @@ typedef uint32_t u32;
 typedef uint64_t u64;
 
 #ifdef __GNUC__
-#define noinline __attribute__((noinline))
+#define noinline	__attribute__((noinline))
+#define always_inline	__attribute__((always_inline))
 #else
 #define noinline
+#define always_inline
 #endif
 
 #endif  /* CRYPTO_TYPES_H */
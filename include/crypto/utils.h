@@ -37,4 +37,17 @@ static inline void memset_secure (void *s, int c, size_t n)
 	barrier_data (s);
 }
 
+/* returns zero if equal, time depends on n only */
+static inline int memcmp_secure (const void *a, const void *b, size_t n)
+{
+	const volatile u8 *p = a, *q = b;
+	u8 diff = 0;
+	size_t i;
+
+	for (i = 0; i < n; ++i)
+		diff |= p[i] ^ q[i];
+
+	return diff != 0;
+}
+
 #endif  /* CRYPTO_UTILS_H */
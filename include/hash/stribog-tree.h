@@ -0,0 +1,44 @@
+/*
+ * Stribog Tree Hash Mode
+ *
+ * Copyright (c) 2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef CRYPTO_STRIBOG_TREE_H
+#define CRYPTO_STRIBOG_TREE_H  1
+
+#include <crypto/core.h>
+#include <crypto/types.h>
+
+/*
+ * Message is split into chunks of fixed size, the last one may be shorter
+ * (and the only one is empty for empty message). With stribog-512 as H:
+ *
+ *	leaf i = H (K || B (LEAF, i)      || chunk i)
+ *	node   = H (K || B (NODE, 0)      || left || right)
+ *	root   = H (K || B (ROOT, length) || top)
+ *
+ * where K is a key zero-padded to a block, absent for unkeyed mode, and
+ * block B holds domain, key length and 64-bit LE parameter. Left subtree
+ * of every node is the largest complete tree with less leaves than node,
+ * thus the root does not depend on how chunks are scheduled.
+ */
+#define STRIBOG_TREE_CHUNK	(1 << 20)
+#define STRIBOG_TREE_KEY_MAX	64
+
+extern const struct crypto_core stribog_tree_core;
+
+/*
+ * Root depends on chunks through leaf digests only: a chunk can be checked
+ * against stored leaf list alone, and the list against trusted root. Leaf
+ * list holds one 64-byte digest per chunk. Returns non-zero on success,
+ * zero otherwise.
+ */
+int stribog_tree_leaf (const void *key, size_t klen, u64 index,
+		       const void *chunk, size_t len, void *out);
+int stribog_tree_root (const void *key, size_t klen,
+		       const void *leaves, u64 length, void *out);
+
+#endif  /* CRYPTO_STRIBOG_TREE_H */
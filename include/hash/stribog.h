@@ -15,4 +15,12 @@
 extern const struct crypto_core stribog_core;
 extern const struct crypto_core stribog_256_core;
 
+#include <crypto/cpu.h>
+
+#ifdef CRYPTO_CPU_X86
+/* state in vector registers, table lookups from general purpose ones */
+extern const struct crypto_core stribog_sse2_core;
+extern const struct crypto_core stribog_256_sse2_core;
+#endif
+
 #endif  /* CRYPTO_STRIBOG_CORE_H */
@@ -10,32 +10,34 @@
  */
 
 #include <errno.h>
-#include <stdlib.h>
 #include <string.h>
 
 #include <crypto/api.h>
 #include <crypto/types.h>
+#include <crypto/utils.h>
 
 #include <kdf/pbkdf1.h>
 
+/* largest supported hash output */
+#define PBKDF1_HASH_MAX	64
+
 struct state {
-	const struct crypto_core *core;
-	void *block;
-	size_t avail;
+	struct crypto crypto;
 
 	struct crypto *prf;
 	const void *salt;
 	size_t salt_len;
 	size_t count;
-	u8 *hash;
+	u8 hash[PBKDF1_HASH_MAX];
 };
 
-static void pbkdf1_fini (struct state *o)
+static void pbkdf1_fini (void *state)
 {
+	struct state *o = state;
+
 	crypto_free (o->prf);
 	o->prf = NULL;
-	free (o->hash);
-	o->hash = NULL;
+	memset_secure (o->hash, 0, sizeof (o->hash));
 }
 
 static int set_prf (struct state *o, va_list ap)
@@ -48,10 +50,10 @@ static int set_prf (struct state *o, va_list ap)
 	pbkdf1_fini (o);
 	o->prf = prf;
 
-	const size_t hs = crypto_get_output_size (prf);
-
-	if ((o->hash = malloc (hs)) == NULL)
-		return -ENOMEM;
+	if (crypto_get_output_size (prf) > sizeof (o->hash)) {
+		pbkdf1_fini (o);
+		return -EINVAL;
+	}
 
 	return 0;
 }
@@ -84,23 +86,27 @@ static int set_salt (struct state *o, va_list ap)
 	return 0;
 }
 
-static void *pbkdf1_alloc (void)
+static void pbkdf1_init (void *state)
 {
-	struct state *o;
-
-	if ((o = malloc (sizeof (*o))) == NULL)
-		return NULL;
+	struct state *o = state;
 
-	o->prf   = NULL;
-	o->count = 0;
-	o->hash  = NULL;
-	return o;
+	o->prf      = NULL;
+	o->salt     = NULL;
+	o->salt_len = 0;
+	o->count    = 0;
 }
 
-static void pbkdf1_free (void *state)
+static int pbkdf1_clone (void *state, const void *from)
 {
-	pbkdf1_fini (state);
-	free (state);
+	const struct state *o = from;
+	struct state *c = state;
+
+	memcpy (c, o, sizeof (*c));
+
+	if (o->prf != NULL && (c->prf = crypto_clone (o->prf)) == NULL)
+		return -errno;
+
+	return 0;
 }
 
 static int pbkdf1_get (const void *state, int type, va_list ap)
@@ -112,7 +118,7 @@ static int pbkdf1_get (const void *state, int type, va_list ap)
 
 	switch (type) {
 	case CRYPTO_OUTPUT_SIZE:
-		return crypto_getv (o->prf, type, ap);
+		return crypto_get_output_size (o->prf);
 	}
 
 	return -ENOSYS;
@@ -167,8 +173,11 @@ static int pbkdf1_fetch (void *state, void *out, size_t len)
 }
 
 const struct crypto_core pbkdf1_core = {
-	.alloc		= pbkdf1_alloc,
-	.free		= pbkdf1_free,
+	.size		= sizeof (struct state),
+
+	.init		= pbkdf1_init,
+	.fini		= pbkdf1_fini,
+	.clone		= pbkdf1_clone,
 
 	.get		= pbkdf1_get,
 	.set		= pbkdf1_set,
@@ -11,7 +11,6 @@
 
 #include <errno.h>
 #include <limits.h>
-#include <stdlib.h>
 #include <string.h>
 
 #include <crypto/api.h>
@@ -42,9 +41,7 @@ static void F (struct crypto *prf, const u8 *salt, size_t salt_len,
 }
 
 struct state {
-	const struct crypto_core *core;
-	void *block;
-	size_t avail;
+	struct crypto crypto;
 
 	struct crypto *prf;
 	const void *salt;
@@ -52,8 +49,10 @@ struct state {
 	size_t count;
 };
 
-static void pbkdf2_fini (struct state *o)
+static void pbkdf2_fini (void *state)
 {
+	struct state *o = state;
+
 	crypto_free (o->prf);
 	o->prf = NULL;
 }
@@ -84,22 +83,27 @@ static int set_salt (struct state *o, va_list ap)
 	return 0;
 }
 
-static void *pbkdf2_alloc (void)
+static void pbkdf2_init (void *state)
 {
-	struct state *o;
-
-	if ((o = malloc (sizeof (*o))) == NULL)
-		return NULL;
+	struct state *o = state;
 
-	o->prf   = NULL;
-	o->count = 0;
-	return o;
+	o->prf      = NULL;
+	o->salt     = NULL;
+	o->salt_len = 0;
+	o->count    = 0;
 }
 
-static void pbkdf2_free (void *state)
+static int pbkdf2_clone (void *state, const void *from)
 {
-	pbkdf2_fini (state);
-	free (state);
+	const struct state *o = from;
+	struct state *c = state;
+
+	memcpy (c, o, sizeof (*c));
+
+	if (o->prf != NULL && (c->prf = crypto_clone (o->prf)) == NULL)
+		return -errno;
+
+	return 0;
 }
 
 static int pbkdf2_get (const void *state, int type, va_list ap)
@@ -163,8 +167,11 @@ static int pbkdf2_fetch (void *state, void *out, size_t len)
 }
 
 const struct crypto_core pbkdf2_core = {
-	.alloc		= pbkdf2_alloc,
-	.free		= pbkdf2_free,
+	.size		= sizeof (struct state),
+
+	.init		= pbkdf2_init,
+	.fini		= pbkdf2_fini,
+	.clone		= pbkdf2_clone,
 
 	.get		= pbkdf2_get,
 	.set		= pbkdf2_set,
@@ -0,0 +1,278 @@
+/*
+ * Crypto API Key Schedule Cache
+ *
+ * Copyright (c) 2023 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/random.h>
+
+#include <crypto/endian.h>
+#include <crypto/key-cache.h>
+#include <crypto/utils.h>
+
+/* longer keys are not cached */
+#define KEY_MAX  64
+
+/*
+ * Entries are found by keyed fingerprint of kind, parameter and key thus
+ * bucket selection does not leak key bits and cannot be flooded from
+ * outside. Key is kept in entry to rule out fingerprint collisions.
+ */
+struct entry {
+	struct entry *prev, *next;	/* LRU list, most recent first */
+	struct entry *chain;		/* bucket chain */
+	u64 fp;
+	const void *kind, *param;
+	size_t len, size;
+	u8 data[];			/* key followed by schedule */
+};
+
+struct cache {
+	pthread_mutex_t lock;
+	size_t limit;			/* zero if disabled */
+	size_t mask;			/* bucket count - 1 */
+	struct entry **bucket;
+	struct entry *head, *tail;
+	u64 secret[2];
+	struct crypto_key_cache_stats stats;
+};
+
+static struct cache cache = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static inline u64 rol64 (u64 x, unsigned count)
+{
+	return x << count | x >> (64 - count);
+}
+
+#define SIPROUND(a, b, c, d)					\
+	a += b; b = rol64 (b, 13); b ^= a; a = rol64 (a, 32);	\
+	c += d; d = rol64 (d, 16); d ^= c;			\
+	a += d; d = rol64 (d, 21); d ^= a;			\
+	c += b; b = rol64 (b, 17); b ^= c; c = rol64 (c, 32);
+
+/* SipHash-2-4 */
+static u64 siphash (const u64 k[2], const u8 *in, size_t len)
+{
+	u64 a = k[0] ^ 0x736f6d6570736575ULL;
+	u64 b = k[1] ^ 0x646f72616e646f6dULL;
+	u64 c = k[0] ^ 0x6c7967656e657261ULL;
+	u64 d = k[1] ^ 0x7465646279746573ULL;
+	u64 m = (u64) len << 56;
+	size_t i;
+
+	for (; len >= 8; len -= 8, in += 8) {
+		const u64 x = read_le64 (in);
+
+		d ^= x;
+		SIPROUND (a, b, c, d);
+		SIPROUND (a, b, c, d);
+		a ^= x;
+	}
+
+	for (i = 0; i < len; ++i)
+		m |= (u64) in[i] << (8 * i);
+
+	d ^= m;
+	SIPROUND (a, b, c, d);
+	SIPROUND (a, b, c, d);
+	a ^= m;
+
+	c ^= 0xff;
+	SIPROUND (a, b, c, d);
+	SIPROUND (a, b, c, d);
+	SIPROUND (a, b, c, d);
+	SIPROUND (a, b, c, d);
+	return a ^ b ^ c ^ d;
+}
+
+static u64 fingerprint (const void *kind, const void *param,
+			const void *key, size_t len)
+{
+	u8 m[2 * sizeof (void *) + KEY_MAX];
+	u64 fp;
+
+	memcpy (m, &kind, sizeof (kind));
+	memcpy (m + sizeof (kind), &param, sizeof (param));
+	memcpy (m + 2 * sizeof (kind), key, len);
+
+	fp = siphash (cache.secret, m, 2 * sizeof (kind) + len);
+	memset_secure (m, 0, sizeof (m));
+	return fp;
+}
+
+static void lru_unlink (struct entry *e)
+{
+	*(e->prev == NULL ? &cache.head : &e->prev->next) = e->next;
+	*(e->next == NULL ? &cache.tail : &e->next->prev) = e->prev;
+}
+
+static void lru_push (struct entry *e)
+{
+	e->prev = NULL;
+	e->next = cache.head;
+	*(cache.head == NULL ? &cache.tail : &cache.head->prev) = e;
+	cache.head = e;
+}
+
+static void entry_free (struct entry *e)
+{
+	memset_secure (e, 0, sizeof (*e) + e->len + e->size);
+	free (e);
+}
+
+static void evict (struct entry *e)
+{
+	struct entry **p = &cache.bucket[e->fp & cache.mask];
+
+	for (; *p != e; p = &(*p)->chain) {}
+
+	*p = e->chain;
+	lru_unlink (e);
+	entry_free (e);
+	--cache.stats.entries;
+}
+
+static struct entry *find (u64 fp, const void *kind, const void *param,
+			   const void *key, size_t len)
+{
+	struct entry *e = cache.bucket[fp & cache.mask];
+
+	for (; e != NULL; e = e->chain)
+		if (e->fp == fp && e->kind == kind && e->param == param &&
+		    e->len == len && memcmp_secure (e->data, key, len) == 0)
+			return e;
+
+	return NULL;
+}
+
+int crypto_key_cache_setup (size_t entries)
+{
+	struct entry **bucket = NULL;
+	size_t n = 0;
+	u64 secret[2] = {};
+
+	if (entries > 0) {
+		for (n = 1; n < entries; n *= 2) {}
+
+		if (getrandom (secret, sizeof (secret), 0) != sizeof (secret))
+			return 0;
+
+		if ((bucket = calloc (n, sizeof (bucket[0]))) == NULL)
+			return 0;
+	}
+
+	pthread_mutex_lock (&cache.lock);
+
+	while (cache.head != NULL)
+		evict (cache.head);
+
+	free (cache.bucket);
+
+	cache.bucket = bucket;
+	cache.mask   = entries > 0 ? n - 1 : 0;
+	memcpy (cache.secret, secret, sizeof (secret));
+	memset (&cache.stats, 0, sizeof (cache.stats));
+	cache.stats.limit = entries;
+	__atomic_store_n (&cache.limit, entries, __ATOMIC_RELAXED);
+
+	pthread_mutex_unlock (&cache.lock);
+	memset_secure (secret, 0, sizeof (secret));
+	return 1;
+}
+
+void crypto_key_cache_get_stats (struct crypto_key_cache_stats *o)
+{
+	pthread_mutex_lock (&cache.lock);
+	*o = cache.stats;
+	pthread_mutex_unlock (&cache.lock);
+}
+
+static int enabled (size_t len)
+{
+	return len <= KEY_MAX &&
+	       __atomic_load_n (&cache.limit, __ATOMIC_RELAXED) > 0;
+}
+
+int crypto_key_cache_lookup (const void *kind, const void *param,
+			     const void *key, size_t len,
+			     void *sched, size_t size)
+{
+	struct entry *e;
+	u64 fp;
+
+	if (!enabled (len))
+		return 0;
+
+	pthread_mutex_lock (&cache.lock);
+
+	if (cache.limit == 0) {
+		pthread_mutex_unlock (&cache.lock);
+		return 0;
+	}
+
+	fp = fingerprint (kind, param, key, len);
+
+	if ((e = find (fp, kind, param, key, len)) != NULL &&
+	    e->size == size) {
+		lru_unlink (e);
+		lru_push (e);
+		memcpy (sched, e->data + len, size);
+		++cache.stats.hits;
+	}
+	else {
+		e = NULL;
+		++cache.stats.misses;
+	}
+
+	pthread_mutex_unlock (&cache.lock);
+	return e != NULL;
+}
+
+void crypto_key_cache_store (const void *kind, const void *param,
+			     const void *key, size_t len,
+			     const void *sched, size_t size)
+{
+	struct entry *e, **p;
+
+	if (!enabled (len) ||
+	    (e = malloc (sizeof (*e) + len + size)) == NULL)
+		return;
+
+	e->kind  = kind;
+	e->param = param;
+	e->len   = len;
+	e->size  = size;
+	memcpy (e->data, key, len);
+	memcpy (e->data + len, sched, size);
+
+	pthread_mutex_lock (&cache.lock);
+
+	if (cache.limit == 0 ||
+	    find (e->fp = fingerprint (kind, param, key, len),
+		  kind, param, key, len) != NULL) {
+		pthread_mutex_unlock (&cache.lock);
+		entry_free (e);
+		return;
+	}
+
+	if (cache.stats.entries >= cache.limit) {
+		evict (cache.tail);
+		++cache.stats.evictions;
+	}
+
+	p = &cache.bucket[e->fp & cache.mask];
+	e->chain = *p;
+	*p = e;
+	lru_push (e);
+	++cache.stats.entries;
+
+	pthread_mutex_unlock (&cache.lock);
+}
@@ -71,9 +71,20 @@ static void cmac_final (void *state, const void *in, size_t len, void *out)
 	memset_secure (W, 0, bs);
 }
 
+static void cmac_init (void *state)
+{
+	struct state *o = state;
+
+	mop_init (o);
+	o->crypto.block = o->block;
+}
+
 const struct crypto_core cmac_core = {
-	.alloc		= mop_alloc,
-	.free		= mop_free,
+	.size		= sizeof (struct state),
+
+	.init		= cmac_init,
+	.fini		= mop_fini,
+	.clone		= mop_clone,
 
 	.get		= mop_get,
 	.set		= mop_set,
@@ -8,7 +8,6 @@
  */
 
 #include <errno.h>
-#include <stdlib.h>
 #include <string.h>
 
 #include <crypto/api.h>
@@ -17,10 +16,14 @@
 
 #include <mac/hmac.h>
 
+/* largest supported hash block */
+#define HMAC_BLOCK_MAX	128
+
 struct state {
 	struct crypto crypto;
+	u8 block[HMAC_BLOCK_MAX];  /* partial block of high-level API */
 	struct crypto *hash;
-	u8 *pad;
+	u8 pad[HMAC_BLOCK_MAX];
 };
 
 static int hmac_reset (struct state *o)
@@ -28,30 +31,26 @@ static int hmac_reset (struct state *o)
 	if (o->hash == NULL)
 		return 0;
 
-	const size_t bs = crypto_get_block_size (o->hash);
-
-	memset_secure (o->pad, 0, bs);
+	memset_secure (o->pad, 0, sizeof (o->pad));
 	crypto_reset (o->hash);
 	return 0;
 }
 
-static void hmac_fini (struct state *o)
+static void hmac_fini (void *state)
 {
+	struct state *o = state;
+
 	if (o->hash == NULL)
 		return;
 
 	hmac_reset (o);
-
 	crypto_free (o->hash);
-	free (o->pad);
-
 	o->hash = NULL;
 }
 
 static int set_algo (struct state *o, va_list ap)
 {
 	struct crypto *algo = va_arg (ap, struct crypto *);
-	int error;
 
 	if (algo == NULL)
 		return -EINVAL;
@@ -62,22 +61,13 @@ static int set_algo (struct state *o, va_list ap)
 	const size_t bs = crypto_get_block_size  (o->hash);
 	const size_t hs = crypto_get_output_size (o->hash);
 
-	if (hs > bs) {
-		error = -EINVAL;
-		goto wrong_hash;
-	}
-
-	if ((o->pad = malloc (bs)) == NULL) {
-		error = -ENOMEM;
-		goto no_pad;
+	if (hs > bs || bs > sizeof (o->pad)) {
+		crypto_free (o->hash);
+		o->hash = NULL;
+		return -EINVAL;
 	}
 
 	return 0;
-no_pad:
-wrong_hash:
-	crypto_free (o->hash);
-	o->hash = NULL;
-	return error;
 }
 
 static void init_hash (struct state *o, size_t bs)
@@ -118,26 +108,39 @@ static int set_key (struct state *o, va_list ap)
 	return 0;
 }
 
-static void *hmac_alloc (void)
+static void hmac_init (void *state)
 {
-	struct state *o;
-
-	if ((o = malloc (sizeof (*o))) == NULL)
-		return NULL;
+	struct state *o = state;
 
+	o->crypto.block = o->block;
 	o->hash = NULL;
-	return o;
+}
+
+static int hmac_clone (void *state, const void *from)
+{
+	const struct state *o = from;
+	struct state *c = state;
+
+	memcpy (c, o, sizeof (*c));
+
+	if (o->hash != NULL && (c->hash = crypto_clone (o->hash)) == NULL)
+		return -errno;
+
+	return 0;
 }
 
 static int hmac_get (const void *state, int type, va_list ap)
 {
 	const struct state *o = state;
 
+	if (o->hash == NULL)
+		return -EINVAL;
+
 	switch (type) {
 	case CRYPTO_BLOCK_SIZE:
+		return crypto_get_block_size  (o->hash);
 	case CRYPTO_OUTPUT_SIZE:
-		return o->hash == NULL ? -EINVAL :
-					 crypto_getv (o->hash, type, ap);
+		return crypto_get_output_size (o->hash);
 	}
 
 	return -ENOSYS;
@@ -154,12 +157,6 @@ static int hmac_set (void *state, int type, va_list ap)
 	return -ENOSYS;
 }
 
-static void hmac_free (void *state)
-{
-	hmac_fini (state);
-	free (state);
-}
-
 static void hmac_transform (void *state, const void *block)
 {
 	struct state *o = state;
@@ -180,8 +177,11 @@ static void hmac_final (void *state, const void *in, size_t len, void *out)
 }
 
 const struct crypto_core hmac_core = {
-	.alloc		= hmac_alloc,
-	.free		= hmac_free,
+	.size		= sizeof (struct state),
+
+	.init		= hmac_init,
+	.fini		= hmac_fini,
+	.clone		= hmac_clone,
 
 	.get		= hmac_get,
 	.set		= hmac_set,
@@ -37,13 +37,63 @@ static void cbc_decrypt (void *state, const void *in, void *out)
 	memcpy (o->iv, in, bs);
 }
 
+static void cbc_encrypt_n (void *state, const void *src, void *dst,
+			   size_t count)
+{
+	struct state *o = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t bs = crypto_get_block_size (o->cipher);
+
+	for (; count > 0; --count, in += bs, out += bs) {
+		xor_block (o->iv, in, o->iv, bs);
+		crypto_encrypt (o->cipher, o->iv, o->iv);
+		memcpy (out, o->iv, bs);
+	}
+}
+
+static void cbc_decrypt_n (void *state, const void *src, void *dst,
+			   size_t count)
+{
+	struct state *o = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t bs = crypto_get_block_size (o->cipher);
+	const size_t max = MOP_CHUNK_SIZE / bs;
+	u8 c[MOP_CHUNK_SIZE];
+	size_t n, i;
+
+	for (; count > 0; count -= n, in += n * bs, out += n * bs) {
+		n = count < max ? count : max;
+
+		memcpy (c, in, n * bs);  /* in and out may be the same */
+		crypto_decrypt_blocks (o->cipher, c, out, n);
+
+		xor_block (o->iv, out, out, bs);
+
+		for (i = 1; i < n; ++i)
+			xor_block (c + (i - 1) * bs, out + i * bs,
+				   out + i * bs, bs);
+
+		memcpy (o->iv, c + (n - 1) * bs, bs);
+	}
+
+	memset_secure (c, 0, sizeof (c));
+}
+
 const struct crypto_core cbc_core = {
-	.alloc		= mop_alloc,
-	.free		= mop_free,
+	.size		= sizeof (struct state),
+
+	.init		= mop_init,
+	.fini		= mop_fini,
+	.clone		= mop_clone,
 
 	.get		= mop_get,
 	.set		= mop_set,
 
 	.encrypt	= cbc_encrypt,
 	.decrypt	= cbc_decrypt,
+
+	.encrypt_n	= cbc_encrypt_n,
+	.decrypt_n	= cbc_decrypt_n,
 };
@@ -37,13 +37,60 @@ static void cfb_decrypt (void *state, const void *in, void *out)
 	xor_block (in, o->iv, out, bs);
 }
 
+static void cfb_encrypt_n (void *state, const void *src, void *dst,
+			   size_t count)
+{
+	struct state *o = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t bs = crypto_get_block_size (o->cipher);
+
+	for (; count > 0; --count, in += bs, out += bs) {
+		crypto_encrypt (o->cipher, o->iv, o->iv);
+		xor_block (in, o->iv, out, bs);
+		memcpy (o->iv, out, bs);
+	}
+}
+
+static void cfb_decrypt_n (void *state, const void *src, void *dst,
+			   size_t count)
+{
+	struct state *o = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t bs = crypto_get_block_size (o->cipher);
+	const size_t max = MOP_CHUNK_SIZE / bs;
+	u8 pat[MOP_CHUNK_SIZE];
+	size_t n;
+
+	for (; count > 0; count -= n, in += n * bs, out += n * bs) {
+		n = count < max ? count : max;
+
+		/* feedback: IV, then all but the last ciphertext block */
+		memcpy (pat, o->iv, bs);
+		memcpy (pat + bs, in, (n - 1) * bs);
+		memcpy (o->iv, in + (n - 1) * bs, bs);
+
+		crypto_encrypt_blocks (o->cipher, pat, pat, n);
+		xor_block (in, pat, out, n * bs);
+	}
+
+	memset_secure (pat, 0, sizeof (pat));
+}
+
 const struct crypto_core cfb_core = {
-	.alloc		= mop_alloc,
-	.free		= mop_free,
+	.size		= sizeof (struct state),
+
+	.init		= mop_init,
+	.fini		= mop_fini,
+	.clone		= mop_clone,
 
 	.get		= mop_get,
 	.set		= mop_set,
 
 	.encrypt	= cfb_encrypt,
 	.decrypt	= cfb_decrypt,
+
+	.encrypt_n	= cfb_encrypt_n,
+	.decrypt_n	= cfb_decrypt_n,
 };
@@ -7,6 +7,8 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <string.h>
+
 #include <crypto/endian.h>
 #include <crypto/utils.h>
 #include <mop/ctr.h>
@@ -18,9 +20,9 @@ static void inc_block_be (const u8 *in, u8 *out, size_t count)
 {
 	u64 n, m, c;
 
-	for (c = 0; count > 0; count -= 8) {
+	for (c = 1; count > 0; count -= 8) {
 		n = read_be64 (in + count - 8);
-		m = n + c + 1;
+		m = n + c;
 		c = m < n;
 		write_be64 (m, out + count - 8);
 	}
@@ -38,13 +40,45 @@ static void ctr_crypt (void *state, const void *in, void *out)
 	inc_block_be (o->iv, o->iv, bs);
 }
 
+static void ctr_crypt_n (void *state, const void *src, void *dst,
+			 size_t count)
+{
+	struct state *o = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t bs = crypto_get_block_size (o->cipher);
+	const size_t max = MOP_CHUNK_SIZE / bs;
+	u8 pat[MOP_CHUNK_SIZE];
+	size_t n, i;
+
+	for (; count > 0; count -= n, in += n * bs, out += n * bs) {
+		n = count < max ? count : max;
+
+		for (i = 0; i < n; ++i) {
+			memcpy (pat + i * bs, o->iv, bs);
+			inc_block_be (o->iv, o->iv, bs);
+		}
+
+		crypto_encrypt_blocks (o->cipher, pat, pat, n);
+		xor_block (in, pat, out, n * bs);
+	}
+
+	memset_secure (pat, 0, sizeof (pat));
+}
+
 const struct crypto_core ctr_core = {
-	.alloc		= mop_alloc,
-	.free		= mop_free,
+	.size		= sizeof (struct state),
+
+	.init		= mop_init,
+	.fini		= mop_fini,
+	.clone		= mop_clone,
 
 	.get		= mop_get,
 	.set		= mop_set,
 
 	.encrypt	= ctr_crypt,
 	.decrypt	= ctr_crypt,
+
+	.encrypt_n	= ctr_crypt_n,
+	.decrypt_n	= ctr_crypt_n,
 };
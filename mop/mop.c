@@ -8,22 +8,17 @@
  */
 
 #include <errno.h>
-#include <stdlib.h>
 #include <string.h>
 
 #include <crypto/utils.h>
 
 #include "mop.h"
 
-void *mop_alloc (void)
+void mop_init (void *state)
 {
-	struct state *o;
-
-	if ((o = malloc (sizeof (*o))) == NULL)
-		return NULL;
+	struct state *o = state;
 
 	o->cipher = NULL;
-	return o;
 }
 
 static int mop_reset (struct state *o)
@@ -31,39 +26,39 @@ static int mop_reset (struct state *o)
 	if (o->cipher == NULL)
 		return 0;
 
-	const size_t bs = crypto_get_block_size (o->cipher);
-
-	memset_secure (o->iv, 0, bs);
+	memset_secure (o->iv, 0, sizeof (o->iv));
 	crypto_reset (o->cipher);
 	return 0;
 }
 
-static void mop_fini (struct state *o)
+void mop_fini (void *state)
 {
+	struct state *o = state;
+
 	if (o->cipher == NULL)
 		return;
 
 	mop_reset (o);
-
 	crypto_free (o->cipher);
-	free (o->iv);
-
 	o->cipher = NULL;
 }
 
-void mop_free (void *state)
+int mop_clone (void *state, const void *from)
 {
-	if (state == NULL)
-		return;
+	const struct state *o = from;
+	struct state *c = state;
+
+	memcpy (c, o, sizeof (*c));
+
+	if (o->cipher != NULL && (c->cipher = crypto_clone (o->cipher)) == NULL)
+		return -errno;
 
-	mop_fini (state);
-	free (state);
+	return 0;
 }
 
 static int set_algo (struct state *o, va_list ap)
 {
 	struct crypto *algo = va_arg (ap, struct crypto *);
-	int error;
 
 	if (algo == NULL)
 		return -EINVAL;
@@ -73,23 +68,15 @@ static int set_algo (struct state *o, va_list ap)
 
 	const size_t bs = crypto_get_block_size (o->cipher);
 
-	if (bs < 8 || bs % 8 != 0) {
+	if (bs < 8 || bs % 8 != 0 || bs > sizeof (o->iv)) {
 		/* we wont support too weak or strange ciphers */
-		error = -EINVAL;
-		goto no_bs;
-	}
-
-	if ((o->iv = calloc (1, bs)) == NULL) {
-		error = -ENOMEM;
-		goto no_iv;
+		crypto_free (o->cipher);
+		o->cipher = NULL;
+		return -EINVAL;
 	}
 
+	memset (o->iv, 0, sizeof (o->iv));
 	return 0;
-no_iv:
-no_bs:
-	crypto_free (o->cipher);
-	o->cipher = NULL;
-	return error;
 }
 
 static int set_iv (struct state *o, va_list ap)
@@ -109,8 +96,14 @@ int mop_get (const void *state, int type, va_list ap)
 {
 	const struct state *o = state;
 
-	if (type == CRYPTO_OUTPUT_SIZE)
-		type = CRYPTO_BLOCK_SIZE;
+	if (o->cipher == NULL)
+		return -EINVAL;
+
+	switch (type) {
+	case CRYPTO_BLOCK_SIZE:
+	case CRYPTO_OUTPUT_SIZE:
+		return crypto_get_block_size (o->cipher);
+	}
 
 	return crypto_getv (o->cipher, type, ap);
 }
@@ -16,14 +16,22 @@
 #include <crypto/core.h>
 #include <crypto/types.h>
 
+/* size of on-stack buffer used to batch blocks for the cipher */
+#define MOP_CHUNK_SIZE	512
+
+/* largest supported cipher block */
+#define MOP_BLOCK_MAX	32
+
 struct state {
 	struct crypto crypto;
+	u8 block[MOP_BLOCK_MAX];  /* partial block of CMAC */
 	struct crypto *cipher;
-	u8 *iv;
+	u8 iv[MOP_BLOCK_MAX];
 };
 
-void *mop_alloc (void);
-void mop_free (void *state);
+void mop_init (void *state);
+void mop_fini (void *state);
+int  mop_clone (void *state, const void *from);
 
 int mop_get (const void *state, int type, va_list ap);
 int mop_set (void *state, int type, va_list ap);
@@ -22,13 +22,33 @@ static void ofb_crypt (void *state, const void *in, void *out)
 	xor_block (in, o->iv, out, bs);
 }
 
+static void ofb_crypt_n (void *state, const void *src, void *dst,
+			 size_t count)
+{
+	struct state *o = state;
+	const u8 *in = src;
+	u8 *out = dst;
+	const size_t bs = crypto_get_block_size (o->cipher);
+
+	for (; count > 0; --count, in += bs, out += bs) {
+		crypto_encrypt (o->cipher, o->iv, o->iv);
+		xor_block (in, o->iv, out, bs);
+	}
+}
+
 const struct crypto_core ofb_core = {
-	.alloc		= mop_alloc,
-	.free		= mop_free,
+	.size		= sizeof (struct state),
+
+	.init		= mop_init,
+	.fini		= mop_fini,
+	.clone		= mop_clone,
 
 	.get		= mop_get,
 	.set		= mop_set,
 
 	.encrypt	= ofb_crypt,
 	.decrypt	= ofb_crypt,
+
+	.encrypt_n	= ofb_crypt_n,
+	.decrypt_n	= ofb_crypt_n,
 };
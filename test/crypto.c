@@ -2,11 +2,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <err.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <crypto/api.h>
+#include <crypto/key-cache.h>
 #include <crypto/types.h>
+#include <hash/stribog-tree.h>
 
 /* convert string or hex-string to blob in-place */
 static int read_blob (char *s, size_t *len)
@@ -58,6 +63,36 @@ static void usage (void)
 
 static struct crypto *algo;
 
+/* algorithm chain and parameters recorded for one-shot functions */
+static const char *outer, *inner;
+static const char *key, *iv;
+static size_t key_len, iv_len;
+
+/* place objects into static memory instead of heap when enabled */
+static _Alignas (CRYPTO_STATE_ALIGN) u8 arena[8192];
+static size_t arena_used;
+static int use_arena;
+
+static struct crypto *make_algo (const char *name)
+{
+	struct crypto *o;
+	size_t size;
+
+	if (!use_arena)
+		return crypto_alloc (name);
+
+	if ((size = crypto_state_size (name)) == 0)
+		return NULL;
+
+	if (size > sizeof (arena) - arena_used)
+		errx (1, "arena overflow");
+
+	if ((o = crypto_init (arena + arena_used, name)) != NULL)
+		arena_used += size;
+
+	return o;
+}
+
 static void set_algo (int argc, char *argv[])
 {
 	struct crypto *o;
@@ -65,24 +100,67 @@ static void set_algo (int argc, char *argv[])
 	if (argc < 2)
 		errx (1, "algo requires an argument");
 
-	if ((o = crypto_alloc (argv[1])) == NULL)
+	if ((o = make_algo (argv[1])) == NULL)
 		err (1, "cannot find algo %s", argv[1]);
 
 	if (algo != NULL && !crypto_set_algo (o, algo))
 		err (1, "cannot set algo to %s", argv[1]);
 
 	algo = o;
+	inner = outer;
+	outer = argv[1];
+}
+
+/* force backend: algo:backend */
+static void set_backend (int argc, char *argv[])
+{
+	char *backend;
+
+	if (argc < 2)
+		errx (1, "backend requires an argument");
+
+	if ((backend = strchr (argv[1], ':')) == NULL)
+		errx (1, "backend format error");
+
+	*backend++ = '\0';
+
+	if (!crypto_set_backend (argv[1], backend))
+		err (1, "cannot set backend %s for %s", backend, argv[1]);
+}
+
+static void clone (void)
+{
+	struct crypto *o;
+
+	if (algo == NULL)
+		errx (1, "algo does not defined");
+
+	if ((o = crypto_clone (algo)) == NULL)
+		err (1, "cannot clone algo");
+
+	crypto_free (algo);  /* clone must not share state with origin */
+	algo = o;
 }
 
 static void set_paramset (int argc, char *argv[])
 {
+	size_t len;
+
 	if (argc < 2)
 		errx (1, "paramset requires an argument");
 
 	if (algo == NULL)
 		errx (1, "algo does not defined");
 
-	if (!crypto_set_paramset (algo, argv[1], 0))
+	/* hex-string is a raw paramset, otherwise it is a name */
+	if (argv[1][0] == 'x') {
+		if (!read_blob (argv[1], &len))
+			err (1, "paramset format error");
+	}
+	else
+		len = 0;
+
+	if (!crypto_set_paramset (algo, argv[1], len))
 		err (1, "cannot set paramset");
 }
 
@@ -101,6 +179,33 @@ static void set_key (int argc, char *argv[])
 
 	if (!crypto_set_key (algo, argv[1], len))
 		err (1, "cannot set key");
+
+	key = argv[1], key_len = len;
+}
+
+static void key_cache (int argc, char *argv[])
+{
+	unsigned long entries;
+	char *end;
+
+	if (argc < 2)
+		errx (1, "key-cache requires an argument");
+
+	entries = strtoul (argv[1], &end, 0);
+	if (end[0] != '\0')
+		errx (1, "key-cache size format error");
+
+	if (!crypto_key_cache_setup (entries))
+		err (1, "cannot setup key cache");
+}
+
+static void key_cache_stats (void)
+{
+	struct crypto_key_cache_stats s;
+
+	crypto_key_cache_get_stats (&s);
+	printf ("hits %lu misses %lu evictions %lu entries %zu/%zu\n",
+		s.hits, s.misses, s.evictions, s.entries, s.limit);
 }
 
 static void set_iv (int argc, char *argv[])
@@ -118,6 +223,8 @@ static void set_iv (int argc, char *argv[])
 
 	if (!crypto_set_iv (algo, argv[1], len))
 		err (1, "cannot set IV");
+
+	iv = argv[1], iv_len = len;
 }
 
 static void set_salt (int argc, char *argv[])
@@ -156,10 +263,43 @@ static void set_count (int argc, char *argv[])
 		err (1, "cannot set count");
 }
 
-static void crypt (int encrypt, int argc, char *argv[])
+static void set_threads (int argc, char *argv[])
+{
+	unsigned long count;
+	char *end;
+
+	if (argc < 2)
+		errx (1, "threads requires an argument");
+
+	if (algo == NULL)
+		errx (1, "algo does not defined");
+
+	count = strtoul (argv[1], &end, 0);
+	if (end[0] != '\0')
+		errx (1, "threads format error");
+
+	if (!crypto_set_threads (algo, count))
+		err (1, "cannot set threads");
+}
+
+static int crypt_once (int encrypt, const void *in, void *out, size_t count)
+{
+	const char *mode = inner == NULL ? NULL : outer;
+	const char *cipher = inner == NULL ? outer : inner;
+
+	if (encrypt)
+		return crypto_encrypt_once (mode, cipher, key, key_len,
+					    iv, iv_len, in, out, count);
+
+	return crypto_decrypt_once (mode, cipher, key, key_len,
+				    iv, iv_len, in, out, count);
+}
+
+static void crypt (int encrypt, int once, int argc, char *argv[])
 {
 	size_t len;
 	size_t bs;
+	int ok;
 
 	if (argc < 2)
 		errx (1, "encrypt/decrypt requires an argument");
@@ -171,17 +311,23 @@ static void crypt (int encrypt, int argc, char *argv[])
 		err (1, "data block format error");
 
 	bs = crypto_get_block_size (algo);
-	if (len != bs)
-		errx (1, "wrong size of block: got %zu, want %zu", len, bs);
+	if (bs == 0 || len == 0 || len % bs != 0)
+		errx (1, "wrong size of data: got %zu, want multiple of %zu",
+		      len, bs);
 
-	u8 block[bs];
+	u8 block[len];
 
-	if (encrypt)
-		crypto_encrypt (algo, argv[1], block);
+	if (once)
+		ok = crypt_once (encrypt, argv[1], block, len / bs);
+	else if (encrypt)
+		ok = crypto_encrypt_blocks (algo, argv[1], block, len / bs);
 	else
-		crypto_decrypt (algo, argv[1], block);
+		ok = crypto_decrypt_blocks (algo, argv[1], block, len / bs);
 
-	show (block, bs);
+	if (!ok)
+		err (1, "cannot process data");
+
+	show (block, len);
 }
 
 static void update (int argc, char *argv[])
@@ -201,6 +347,251 @@ static void update (int argc, char *argv[])
 		err (1, "cannot push data");
 }
 
+static u8 *map_file (const char *path, size_t *len)
+{
+	struct stat st;
+	FILE *f;
+	void *p;
+
+	if ((f = fopen (path, "rb")) == NULL || fstat (fileno (f), &st) != 0)
+		err (1, "cannot open %s", path);
+
+	*len = st.st_size;
+	p = *len == 0 ? NULL :
+			mmap (NULL, *len, PROT_READ, MAP_PRIVATE, fileno (f), 0);
+
+	if (p == MAP_FAILED)
+		err (1, "cannot map %s", path);
+
+	fclose (f);
+	return p;
+}
+
+static void unmap_file (u8 *data, size_t len)
+{
+	if (len > 0)
+		munmap (data, len);
+}
+
+/* push whole file at once, thus tree mode can hash chunks in parallel */
+static void update_file (int argc, char *argv[])
+{
+	size_t len;
+	u8 *data;
+
+	if (argc < 2)
+		errx (1, "file requires an argument");
+
+	if (algo == NULL)
+		errx (1, "algo does not defined");
+
+	data = map_file (argv[1], &len);
+
+	if (len > 0 && !crypto_update (algo, data, len))
+		err (1, "cannot push data");
+
+	unmap_file (data, len);
+}
+
+static size_t tree_leaves (size_t len)
+{
+	return len == 0 ? 1 : (len - 1) / STRIBOG_TREE_CHUNK + 1;
+}
+
+/* leaf digest of one chunk of file, as stored in leaf list */
+static void tree_leaf (int argc, char *argv[])
+{
+	unsigned long long index;
+	size_t len, offset, n;
+	char *end;
+	u8 *data, hash[64];
+
+	if (argc < 3)
+		errx (1, "tree-leaf requires file and chunk index");
+
+	index = strtoull (argv[2], &end, 0);
+	if (end[0] != '\0')
+		errx (1, "chunk index format error");
+
+	data = map_file (argv[1], &len);
+
+	if (index >= tree_leaves (len))
+		errx (1, "chunk index out of range");
+
+	offset = index * STRIBOG_TREE_CHUNK;
+	n = len - offset < STRIBOG_TREE_CHUNK ? len - offset :
+						STRIBOG_TREE_CHUNK;
+
+	if (!stribog_tree_leaf (key, key_len, index, data + offset, n, hash))
+		err (1, "cannot hash chunk");
+
+	unmap_file (data, len);
+	show (hash, sizeof (hash));
+}
+
+/* root digest from leaf digests of chunks hashed one by one */
+static void tree_root (int argc, char *argv[])
+{
+	size_t len, count, i, n;
+	u8 *data, *leaves, root[64];
+
+	if (argc < 2)
+		errx (1, "tree-root requires an argument");
+
+	data  = map_file (argv[1], &len);
+	count = tree_leaves (len);
+
+	if ((leaves = malloc (count * 64)) == NULL)
+		err (1, "cannot allocate leaf list");
+
+	for (i = 0; i < count; ++i) {
+		n = len - i * STRIBOG_TREE_CHUNK;
+		n = n < STRIBOG_TREE_CHUNK ? n : STRIBOG_TREE_CHUNK;
+
+		if (!stribog_tree_leaf (key, key_len, i,
+					data + i * STRIBOG_TREE_CHUNK, n,
+					leaves + i * 64))
+			err (1, "cannot hash chunk");
+	}
+
+	if (!stribog_tree_root (key, key_len, leaves, len, root))
+		err (1, "cannot hash leaf list");
+
+	free (leaves);
+	unmap_file (data, len);
+	show (root, sizeof (root));
+}
+
+/*
+ * push data as fragments of growing size: 1, 2, 3, ... bytes, show data
+ * afterwards if it is encrypted in place
+ */
+static void updatev (int argc, char *argv[], int in_place)
+{
+	size_t total;
+	size_t len, i, n;
+	char *p;
+
+	if (argc < 2)
+		errx (1, "updatev requires an argument");
+
+	if (algo == NULL)
+		errx (1, "algo does not defined");
+
+	if (!read_blob (argv[1], &len))
+		err (1, "data block format error");
+
+	struct iovec iov[len + 1];
+
+	total = len;
+
+	for (i = 0, p = argv[1]; len > 0; ++i, p += n, len -= n) {
+		n = i + 1 < len ? i + 1 : len;
+		iov[i].iov_base = p;
+		iov[i].iov_len  = n;
+	}
+
+	if (!crypto_updatev (algo, iov, i))
+		err (1, "cannot push data");
+
+	if (in_place)
+		show (argv[1], total);
+}
+
+/* one-shot digest or MAC of data with recorded algorithm chain */
+static size_t digest (const void *in, size_t len, void *out)
+{
+	if (inner == NULL)
+		return crypto_digest (outer, in, len, out);
+
+	return crypto_mac (outer, inner, key, key_len, in, len, out);
+}
+
+static void digest_once (int argc, char *argv[])
+{
+	size_t len, hs;
+
+	if (argc < 2)
+		errx (1, "digest requires an argument");
+
+	if (algo == NULL)
+		errx (1, "algo does not defined");
+
+	if (!read_blob (argv[1], &len))
+		err (1, "data block format error");
+
+	if ((hs = crypto_get_output_size (algo)) == 0)
+		err (1, "cannot get output size");
+
+	u8 hash[hs];
+
+	if (digest (argv[1], len, hash) != hs)
+		err (1, "cannot digest data");
+
+	show (hash, hs);
+}
+
+/* one-shot digests of comma-separated messages */
+static void digest_many (int argc, char *argv[])
+{
+	size_t count, i, len, hs;
+	char *p, *next;
+
+	if (argc < 2)
+		errx (1, "digest-many requires an argument");
+
+	if (algo == NULL)
+		errx (1, "algo does not defined");
+
+	for (count = 1, p = argv[1]; (p = strchr (p, ',')) != NULL; ++p)
+		++count;
+
+	struct iovec iov[count];
+
+	for (i = 0, p = argv[1]; i < count; ++i, p = next) {
+		if ((next = strchr (p, ',')) != NULL)
+			*next++ = '\0';
+
+		if (!read_blob (p, &len))
+			err (1, "data block format error");
+
+		iov[i].iov_base = p;
+		iov[i].iov_len  = len;
+	}
+
+	if ((hs = crypto_get_output_size (algo)) == 0)
+		err (1, "cannot get output size");
+
+	u8 hash[count * hs];
+
+	if (crypto_digest_many (outer, iov, count, hash) != hs)
+		err (1, "cannot digest data");
+
+	show (hash, count * hs);
+}
+
+/* full object life cycle to compare one-shot functions against */
+static void digest_object (const void *in, size_t len, void *out, size_t hs)
+{
+	struct crypto *o, *h;
+
+	if ((o = crypto_alloc (outer)) == NULL)
+		err (1, "cannot find algo %s", outer);
+
+	if (inner != NULL) {
+		if ((h = crypto_alloc (inner)) == NULL)
+			err (1, "cannot find algo %s", inner);
+
+		if (!crypto_set_algo (o, h) ||
+		    !crypto_set_key (o, key, key_len))
+			err (1, "cannot set algo");
+	}
+
+	crypto_update (o, in, len);
+	crypto_fetch  (o, out, hs);
+	crypto_free (o);
+}
+
 static void fetch (int argc, char *argv[])
 {
 	size_t len;
@@ -224,6 +615,149 @@ static void fetch (int argc, char *argv[])
 	show (block, len);
 }
 
+/* simulate cache pressure from neighbours: touch this much memory between
+   bench operations, time spent here is not counted */
+static volatile u8 *evict_buf;
+static size_t evict_len;
+
+static void set_evict (int argc, char *argv[])
+{
+	char *end;
+
+	if (argc < 2)
+		errx (1, "evict requires an argument");
+
+	evict_len = strtoul (argv[1], &end, 0);
+	if (end[0] != '\0')
+		errx (1, "evict size format error");
+
+	free ((void *) evict_buf);
+
+	if ((evict_buf = calloc (1, evict_len + 1)) == NULL)
+		err (1, "cannot allocate evict buffer");
+}
+
+static void evict (void)
+{
+	size_t i;
+
+	for (i = 0; i < evict_len; i += 64)
+		++evict_buf[i];
+}
+
+static double now (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* messages per operation of multi-message bench */
+#define BENCH_MANY  64
+
+static void bench (int argc, char *argv[])
+{
+	size_t len, bs, hs, i, scale = 1;
+	char *end;
+	unsigned long n;
+	double start, t, skip;
+
+	if (argc < 3)
+		errx (1, "bench requires operation and size");
+
+	if (algo == NULL)
+		errx (1, "algo does not defined");
+
+	len = strtoul (argv[2], &end, 0);
+	if (end[0] != '\0' || len == 0)
+		errx (1, "size format error");
+
+	if (strcmp (argv[1], "many") == 0)
+		scale = BENCH_MANY;
+
+	u8 *data = calloc (1, len * scale + 64);
+	struct iovec many[BENCH_MANY];
+	u8 hash[BENCH_MANY * 64];
+
+	if (data == NULL)
+		err (1, "cannot allocate bench buffer");
+
+	for (i = 0; i < BENCH_MANY; ++i) {
+		many[i].iov_base = data + (scale > 1 ? i * len : 0);
+		many[i].iov_len  = len;
+	}
+
+	struct crypto_spec *spec = crypto_spec_parse (outer);
+
+	if (spec == NULL)
+		err (1, "cannot parse algo %s", outer);
+
+	for (n = 0, skip = 0, start = now (); (t = now () - start) < 1; ++n) {
+		if (evict_len > 0) {
+			evict ();
+			skip += now () - start - t;
+		}
+
+		if (strcmp (argv[1], "encrypt") == 0 ||
+		    strcmp (argv[1], "decrypt") == 0) {
+			if ((bs = crypto_get_block_size (algo)) == 0)
+				err (1, "cannot get block size");
+
+			if (argv[1][0] == 'e')
+				crypto_encrypt_blocks (algo, data, data, len / bs);
+			else
+				crypto_decrypt_blocks (algo, data, data, len / bs);
+		}
+		else if (strcmp (argv[1], "update") == 0) {
+			if ((hs = crypto_get_output_size (algo)) == 0)
+				err (1, "cannot get output size");
+
+			if (hs > 64)
+				hs = 64;
+
+			crypto_update (algo, data, len);
+			crypto_fetch  (algo, data, hs);
+		}
+		else if (strcmp (argv[1], "digest") == 0)
+			digest (data, len, data);
+		else if (strcmp (argv[1], "many") == 0)
+			crypto_digest_many (outer, many, BENCH_MANY, hash);
+		else if (strcmp (argv[1], "key") == 0) {
+			if (!crypto_set_key (algo, data, len))
+				err (1, "cannot set key");
+		}
+		else if (strcmp (argv[1], "keyed") == 0) {
+			if ((bs = crypto_get_block_size (algo)) == 0)
+				err (1, "cannot get block size");
+
+			if (!crypto_set_key (algo, key, key_len))
+				err (1, "cannot set key");
+
+			crypto_encrypt_blocks (algo, data, data, len / bs);
+		}
+		else if (strcmp (argv[1], "alloc") == 0)
+			crypto_free (crypto_alloc (outer));
+		else if (strcmp (argv[1], "spec") == 0)
+			crypto_free (crypto_spec_alloc (spec));
+		else if (strcmp (argv[1], "object") == 0) {
+			if ((hs = crypto_get_output_size (algo)) == 0)
+				err (1, "cannot get output size");
+
+			digest_object (data, len, data, hs > 64 ? 64 : hs);
+		}
+		else
+			errx (1, "unknown bench operation %s", argv[1]);
+	}
+
+	t -= skip;
+
+	printf ("%s %zu: %lu ops in %.3f s, %.0f ns/op, %.1f MB/s\n",
+		argv[1], len, n, t, t * 1e9 / n, n * len * scale / t / 1e6);
+	crypto_spec_free (spec);
+	free (data);
+}
+
 int main (int argc, char *argv[])
 {
 	--argc, ++argv;
@@ -233,6 +767,25 @@ int main (int argc, char *argv[])
 			set_algo (argc, argv);
 			argc -= 2, argv += 2;
 		}
+		else if (strcmp (argv[0], "arena") == 0) {
+			use_arena = 1;
+			--argc, ++argv;
+		}
+		else if (strcmp (argv[0], "backend") == 0) {
+			set_backend (argc, argv);
+			argc -= 2, argv += 2;
+		}
+		else if (strcmp (argv[0], "clone") == 0) {
+			clone ();
+			--argc, ++argv;
+		}
+		else if (strcmp (argv[0], "reset") == 0) {
+			if (algo == NULL)
+				errx (1, "algo does not defined");
+
+			crypto_reset (algo);
+			--argc, ++argv;
+		}
 		else if (strcmp (argv[0], "paramset") == 0) {
 			set_paramset (argc, argv);
 			argc -= 2, argv += 2;
@@ -241,6 +794,14 @@ int main (int argc, char *argv[])
 			set_key (argc, argv);
 			argc -= 2, argv += 2;
 		}
+		else if (strcmp (argv[0], "key-cache") == 0) {
+			key_cache (argc, argv);
+			argc -= 2, argv += 2;
+		}
+		else if (strcmp (argv[0], "key-cache-stats") == 0) {
+			key_cache_stats ();
+			--argc, ++argv;
+		}
 		else if (strcmp (argv[0], "iv") == 0) {
 			set_iv (argc, argv);
 			argc -= 2, argv += 2;
@@ -253,22 +814,70 @@ int main (int argc, char *argv[])
 			set_count (argc, argv);
 			argc -= 2, argv += 2;
 		}
+		else if (strcmp (argv[0], "threads") == 0) {
+			set_threads (argc, argv);
+			argc -= 2, argv += 2;
+		}
 		else if (strcmp (argv[0], "encrypt") == 0) {
-			crypt (1, argc, argv);
+			crypt (1, 0, argc, argv);
 			argc -= 2, argv += 2;
 		}
 		else if (strcmp (argv[0], "decrypt") == 0) {
-			crypt (0, argc, argv);
+			crypt (0, 0, argc, argv);
+			argc -= 2, argv += 2;
+		}
+		else if (strcmp (argv[0], "encrypt-once") == 0) {
+			crypt (1, 1, argc, argv);
+			argc -= 2, argv += 2;
+		}
+		else if (strcmp (argv[0], "decrypt-once") == 0) {
+			crypt (0, 1, argc, argv);
+			argc -= 2, argv += 2;
+		}
+		else if (strcmp (argv[0], "digest") == 0) {
+			digest_once (argc, argv);
+			argc -= 2, argv += 2;
+		}
+		else if (strcmp (argv[0], "digest-many") == 0) {
+			digest_many (argc, argv);
 			argc -= 2, argv += 2;
 		}
 		else if (strcmp (argv[0], "update") == 0) {
 			update (argc, argv);
 			argc -= 2, argv += 2;
 		}
+		else if (strcmp (argv[0], "updatev") == 0) {
+			updatev (argc, argv, 0);
+			argc -= 2, argv += 2;
+		}
+		else if (strcmp (argv[0], "encryptv") == 0) {
+			updatev (argc, argv, 1);
+			argc -= 2, argv += 2;
+		}
+		else if (strcmp (argv[0], "file") == 0) {
+			update_file (argc, argv);
+			argc -= 2, argv += 2;
+		}
+		else if (strcmp (argv[0], "tree-leaf") == 0) {
+			tree_leaf (argc, argv);
+			argc -= 3, argv += 3;
+		}
+		else if (strcmp (argv[0], "tree-root") == 0) {
+			tree_root (argc, argv);
+			argc -= 2, argv += 2;
+		}
 		else if (strcmp (argv[0], "fetch") == 0) {
 			fetch (argc, argv);
 			argc -= 2, argv += 2;
 		}
+		else if (strcmp (argv[0], "evict") == 0) {
+			set_evict (argc, argv);
+			argc -= 2, argv += 2;
+		}
+		else if (strcmp (argv[0], "bench") == 0) {
+			bench (argc, argv);
+			argc -= 3, argv += 3;
+		}
 		else
 			usage ();
 	}